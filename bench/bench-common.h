@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LBM_BENCH_HAS_TSC 1
+#else
+#define LBM_BENCH_HAS_TSC 0
+#endif
+
+namespace lbm::bench {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double kTwoPi = 6.283185307179586;
+
+inline double seconds_since(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+#ifdef _WIN32
+inline double filetime_seconds(const FILETIME &ft)
+{
+	ULARGE_INTEGER v;
+	v.LowPart = ft.dwLowDateTime;
+	v.HighPart = ft.dwHighDateTime;
+	return static_cast<double>(v.QuadPart) * 1e-7; // 100 ns units
+}
+#endif
+
+// CPU time consumed by the whole process (all threads), in seconds
+inline double process_cpu_seconds()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0.0;
+	return filetime_seconds(kernel) + filetime_seconds(user);
+#else
+	rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0.0;
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 + usage.ru_stime.tv_sec +
+	       usage.ru_stime.tv_usec * 1e-6;
+#endif
+}
+
+// CPU time consumed by the calling thread, in seconds
+inline double thread_cpu_seconds()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+		return 0.0;
+	return filetime_seconds(kernel) + filetime_seconds(user);
+#else
+	timespec ts{};
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+		return 0.0;
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Time-stamp counter (reference cycles) where available, 0 otherwise
+inline uint64_t cycle_counter()
+{
+#if LBM_BENCH_HAS_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// Keep the compiler from optimizing away a computed value
+template<typename T> inline void do_not_optimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile T sink;
+	sink = value;
+#endif
+}
+
+// Compiler barrier for buffers written in place
+inline void clobber_memory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : : "memory");
+#else
+	_ReadWriteBarrier();
+#endif
+}
+
+// Deterministic test signal generator (sine tone or white noise)
+class SignalGenerator {
+public:
+	enum class Kind { Tone, Noise };
+
+	SignalGenerator(Kind kind, double amplitude_dbfs, double frequency_hz, uint32_t sample_rate,
+			uint32_t seed = 0x12345678u)
+		: kind_(kind),
+		  amplitude_(std::pow(10.0, amplitude_dbfs / 20.0)),
+		  phase_step_(kTwoPi * frequency_hz / sample_rate),
+		  rng_(seed ? seed : 1u)
+	{
+	}
+
+	void fill(float *out, uint32_t frames)
+	{
+		if (kind_ == Kind::Tone) {
+			for (uint32_t i = 0; i < frames; ++i) {
+				out[i] = static_cast<float>(amplitude_ * std::sin(phase_));
+				phase_ += phase_step_;
+				if (phase_ >= kTwoPi)
+					phase_ -= kTwoPi;
+			}
+		} else {
+			for (uint32_t i = 0; i < frames; ++i) {
+				// xorshift32 -> uniform [-1, 1)
+				rng_ ^= rng_ << 13;
+				rng_ ^= rng_ >> 17;
+				rng_ ^= rng_ << 5;
+				double u = static_cast<double>(rng_) / 2147483648.0 - 1.0;
+				out[i] = static_cast<float>(amplitude_ * u);
+			}
+		}
+	}
+
+private:
+	Kind kind_;
+	double amplitude_;
+	double phase_step_;
+	double phase_{0.0};
+	uint32_t rng_;
+};
+
+// Summary of a latency sample set (values in microseconds)
+struct LatencySummary {
+	double mean_us{0.0};
+	double p50_us{0.0};
+	double p99_us{0.0};
+	double max_us{0.0};
+};
+
+inline LatencySummary summarize(std::vector<double> samples_us)
+{
+	LatencySummary s;
+	if (samples_us.empty())
+		return s;
+
+	std::sort(samples_us.begin(), samples_us.end());
+	double sum = 0.0;
+	for (double v : samples_us)
+		sum += v;
+
+	auto percentile = [&samples_us](double p) {
+		size_t idx = static_cast<size_t>(p * (samples_us.size() - 1) + 0.5);
+		return samples_us[idx];
+	};
+
+	s.mean_us = sum / samples_us.size();
+	s.p50_us = percentile(0.50);
+	s.p99_us = percentile(0.99);
+	s.max_us = samples_us.back();
+	return s;
+}
+
+// Parse a comma-separated list of unsigned integers ("256,480,1024")
+inline std::vector<uint32_t> parse_u32_list(const std::string &text)
+{
+	std::vector<uint32_t> values;
+	size_t pos = 0;
+	while (pos < text.size()) {
+		size_t comma = text.find(',', pos);
+		if (comma == std::string::npos)
+			comma = text.size();
+		std::string item = text.substr(pos, comma - pos);
+		if (!item.empty())
+			values.push_back(static_cast<uint32_t>(std::strtoul(item.c_str(), nullptr, 10)));
+		pos = comma + 1;
+	}
+	return values;
+}
+
+} // namespace lbm::bench
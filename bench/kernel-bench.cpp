@@ -0,0 +1,384 @@
+// Microbenchmarks for the capture hot-path kernels
+//
+// Times each kernel that runs per audio block (fused capture pass, peak, RMS, queue transfer)
+// across block sizes, channel layouts and buffer alignments, and reports ns/sample and cycles/block.
+// The capture pass runs on every SIMD level the CPU supports; each level is first checked against the scalar
+// kernel (identical samples and peak, same sum of squares within rounding) and the run fails on a mismatch.
+// Use --csv to record a baseline for comparing future SIMD or layout changes.
+
+#include "bench-common.h"
+
+#include "audio-frame.h"
+#include "audio-kernels.h"
+#include "channel-layout.h"
+#include "sample-ring.h"
+#include "vad.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+using namespace lbm;
+using namespace lbm::bench;
+
+namespace {
+
+struct Options {
+	std::vector<uint32_t> block_sizes{64, 128, 256, 480, 512, 1024, 2048, 4096};
+	double min_time_ms{20.0}; // minimum measured time per trial
+	int trials{5};            // best-of-N
+	bool csv{false};
+};
+
+void print_usage(const char *argv0)
+{
+	std::printf("Usage: %s [options]\n"
+		    "  --block-sizes LIST   comma-separated block sizes (default 64..4096)\n"
+		    "  --min-time-ms N      minimum time per trial (default 20)\n"
+		    "  --trials N           trials per case, best is reported (default 5)\n"
+		    "  --csv                CSV output\n",
+		    argv0);
+}
+
+bool parse_options(int argc, char **argv, Options &opts)
+{
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (std::strcmp(arg, "--csv") == 0) {
+			opts.csv = true;
+		} else if (std::strcmp(arg, "--block-sizes") == 0 && value) {
+			opts.block_sizes = parse_u32_list(value);
+			++i;
+		} else if (std::strcmp(arg, "--min-time-ms") == 0 && value) {
+			opts.min_time_ms = std::atof(value);
+			++i;
+		} else if (std::strcmp(arg, "--trials") == 0 && value) {
+			opts.trials = std::max(1, std::atoi(value));
+			++i;
+		} else {
+			return false;
+		}
+	}
+
+	for (uint32_t block : opts.block_sizes) {
+		if (block == 0 || block > AudioFrame::kMaxSamples) {
+			std::fprintf(stderr, "Block size must be 1..%zu\n", AudioFrame::kMaxSamples);
+			return false;
+		}
+	}
+	return !opts.block_sizes.empty();
+}
+
+constexpr SimdLevel kSimdLevels[] = {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON};
+
+// Sample buffer with a controllable alignment offset from a 64-byte boundary
+class AlignedBuffer {
+public:
+	AlignedBuffer(uint32_t frames, size_t offset_bytes) : storage_(frames + 64)
+	{
+		auto base = reinterpret_cast<uintptr_t>(storage_.data());
+		uintptr_t aligned = (base + 63) & ~static_cast<uintptr_t>(63);
+		data_ = reinterpret_cast<float *>(aligned + offset_bytes);
+	}
+
+	float *data() { return data_; }
+
+private:
+	std::vector<float> storage_;
+	float *data_;
+};
+
+struct Measurement {
+	double ns_per_block{0.0};
+	double cycles_per_block{0.0};
+};
+
+// Run `fn` repeatedly; returns the best trial
+template<typename Fn> Measurement measure(const Options &opts, Fn &&fn)
+{
+	// Calibrate iteration count to reach min_time_ms
+	uint64_t iters = 1;
+	for (;;) {
+		auto start = Clock::now();
+		for (uint64_t i = 0; i < iters; ++i)
+			fn();
+		double ms = seconds_since(start) * 1e3;
+		if (ms >= opts.min_time_ms || iters >= (1ull << 30))
+			break;
+		iters *= (ms < opts.min_time_ms / 10.0) ? 10 : 2;
+	}
+
+	Measurement best{1e300, 1e300};
+	for (int t = 0; t < opts.trials; ++t) {
+		const uint64_t c0 = cycle_counter();
+		const auto start = Clock::now();
+		for (uint64_t i = 0; i < iters; ++i)
+			fn();
+		const double ns = seconds_since(start) * 1e9 / iters;
+		const double cycles = static_cast<double>(cycle_counter() - c0) / iters;
+		if (ns < best.ns_per_block) {
+			best.ns_per_block = ns;
+			best.cycles_per_block = cycles;
+		}
+	}
+	return best;
+}
+
+void report(const Options &opts, const char *kernel, const char *layout, size_t align, uint32_t block,
+	    const Measurement &m)
+{
+	if (opts.csv) {
+		std::printf("%s,%s,%zu,%u,%.2f,%.4f,%.0f\n", kernel, layout, align, block, m.ns_per_block,
+			    m.ns_per_block / block, LBM_BENCH_HAS_TSC ? m.cycles_per_block : 0.0);
+	} else if (LBM_BENCH_HAS_TSC) {
+		std::printf("%-16s %-7s %5zu %6u %12.1f %10.4f %12.0f\n", kernel, layout, align, block, m.ns_per_block,
+			    m.ns_per_block / block, m.cycles_per_block);
+	} else {
+		std::printf("%-16s %-7s %5zu %6u %12.1f %10.4f %12s\n", kernel, layout, align, block, m.ns_per_block,
+			    m.ns_per_block / block, "n/a");
+	}
+	std::fflush(stdout);
+}
+
+void run_block(const Options &opts, uint32_t block)
+{
+	// 0 = 64-byte aligned, 4 = misaligned by one float
+	static constexpr size_t kAlignments[] = {0, 4};
+	static constexpr ChannelLayout kCaptureLayouts[] = {ChannelLayout::Mono, ChannelLayout::Stereo,
+							    ChannelLayout::Surround7_1};
+
+	for (size_t align : kAlignments) {
+		AlignedBuffer left(block, align), right(block, align), mono(block, align);
+		AlignedBuffer planar(block * kMaxChannels, align);
+		SignalGenerator gen_l(SignalGenerator::Kind::Noise, -12.0, 0.0, 48000, 1);
+		SignalGenerator gen_r(SignalGenerator::Kind::Noise, -12.0, 0.0, 48000, 2);
+		gen_l.fill(left.data(), block);
+		gen_r.fill(right.data(), block);
+		std::memcpy(mono.data(), left.data(), block * sizeof(float));
+
+		// AudioCaptureManager::capture_planes (planar copy + non-unity fader + peak + sum of squares)
+		const float *planes[kMaxChannels];
+		for (uint32_t c = 0; c < kMaxChannels; ++c) {
+			planes[c] = (c % 2) ? right.data() : left.data();
+		}
+		for (SimdLevel level : kSimdLevels) {
+			if (!simd_level_supported(level)) {
+				continue;
+			}
+			const std::string name = std::string("capture_") + simd_level_name(level);
+			for (ChannelLayout layout : kCaptureLayouts) {
+				const uint32_t channels = channel_count(layout);
+				const char *layout_name = channel_layout_name(layout);
+				report(opts, name.c_str(), layout_name, align, block, measure(opts, [&] {
+					       do_not_optimize(kernels::capture_planes(level, planes, channels,
+										       planar.data(), block, 0.8f)
+								       .sum_squares);
+					       clobber_memory();
+				       }));
+			}
+		}
+
+		// SummingBus::accumulate (summing one BGM block into the bus)
+		report(opts, "accumulate", "mono", align, block, measure(opts, [&] {
+			       kernels::accumulate(mono.data(), left.data(), block);
+			       kernels::accumulate(mono.data(), right.data(), block);
+			       clobber_memory();
+		       }));
+
+		// Separate peak / energy passes, as still used on the summed buses
+		report(opts, "peak_abs", "mono", align, block,
+		       measure(opts, [&] { do_not_optimize(kernels::peak_abs(left.data(), block)); }));
+		report(opts, "sum_squares", "mono", align, block,
+		       measure(opts, [&] { do_not_optimize(kernels::sum_squares(left.data(), block)); }));
+
+		// The voice capture, also splitting the energy at the VAD's 10 ms hop ends
+		uint32_t phase = 0;
+		report(opts, "capture_hops", "stereo", align, block, measure(opts, [&] {
+			       HopEnergy hops;
+			       hops.hop = 480;
+			       hops.first = 480 - phase;
+			       phase = (phase + block) % 480;
+			       do_not_optimize(kernels::capture_planes(planes, 2, planar.data(), block, 0.8f, hops)
+						       .sum_squares);
+			       clobber_memory();
+		       }));
+
+		// VoiceActivityDetector::update: 10 ms hops re-blocked from the callback block, reading the samples
+		VoiceActivityDetector vad;
+		report(opts, "vad_update", "mono", align, block, measure(opts, [&] {
+			       for (uint32_t done = 0; done < block;) {
+				       done += vad.update(left.data() + done, block - done);
+			       }
+			       do_not_optimize(vad.is_active());
+		       }));
+
+		// The same from the hop sums the capture split off (as the worker runs it on queued voice): the hop
+		// ends move through the blocks as in the stream, so every phase the capture produces is split up front
+		// and the blocks cycle through them
+		std::vector<HopEnergy> splits(480 / std::gcd(block, 480u));
+		for (size_t n = 0; n < splits.size(); ++n) {
+			splits[n].hop = 480;
+			splits[n].first = 480 - static_cast<uint32_t>(n * block % 480);
+			kernels::capture_planes(planes, 1, mono.data(), block, 1.0f, splits[n]);
+		}
+		AudioFrame voice;
+		voice.samples = left.data();
+		voice.frame_count = block;
+		size_t next = 0;
+		vad.reset();
+		report(opts, "vad_hops", "mono", align, block, measure(opts, [&] {
+			       voice.hops = &splits[next];
+			       next = (next + 1) % splits.size();
+			       for (uint32_t done = 0; done < block;) {
+				       done += vad.update(voice, done);
+			       }
+			       do_not_optimize(vad.is_active());
+		       }));
+	}
+
+	// SampleRing::try_reserve/commit + try_peek/release: the zero-copy queue used by the capture callbacks
+	SampleRing ring;
+	ring.allocate(2 * 48000, 2 * 48000 / 64);
+	AudioFrame frame;
+	report(opts, "sample_ring", "frame", 0, block, measure(opts, [&] {
+		       float *dest = ring.try_reserve(block);
+		       dest[0] = 0.0f;
+		       ring.commit(block, BlockStats{}, 0);
+		       ring.try_peek(frame);
+		       do_not_optimize(frame.samples[0]);
+		       ring.release();
+	       }));
+}
+
+// The hop-split capture against the plain scalar one (`expected`, `ref`): the same samples, and each piece's sum
+// is the energy of its range
+bool check_hop_split(SimdLevel level, const float *const *planes, uint32_t channels, uint32_t frames, float volume,
+		     uint32_t hop, const float *expected, const BlockStats &ref, float *actual)
+{
+	HopEnergy hops;
+	hops.hop = hop;
+	hops.first = 1 + (frames * 7) % hop;
+	std::fill(actual, actual + static_cast<size_t>(frames) * channels, 1.0f);
+	const BlockStats got = kernels::capture_planes(level, planes, channels, actual, frames, volume, hops);
+	bool match = std::memcmp(expected, actual, static_cast<size_t>(frames) * channels * sizeof(float)) == 0 &&
+		     got.peak == ref.peak && std::fabs(got.sum_squares - ref.sum_squares) <= 1e-12 * ref.sum_squares;
+
+	const uint32_t pieces = hops.count(frames);
+	match &= hops.pieces == (pieces <= HopEnergy::kMaxPieces ? pieces : 0);
+	for (uint32_t i = 0; i < hops.pieces; ++i) {
+		const uint32_t start = hops.start(i);
+		double energy = 0.0;
+		for (uint32_t c = 0; c < channels; ++c) {
+			energy += kernels::sum_squares(expected + c * frames + start, hops.end(i, frames) - start);
+		}
+		match &= std::fabs(hops.sums[i] - energy) <= 1e-12 * energy;
+	}
+	return match;
+}
+
+// Every capture kernel must write the same samples and peak as the scalar one; the sum of squares may differ
+// only by summation order. Odd lengths cover the scalar tail after the last full vector; the stereo case with a
+// missing second plane covers the silence fill.
+bool check_capture_kernels()
+{
+	static constexpr uint32_t kLengths[] = {1, 7, 61, 480, 1023};
+	static constexpr float kVolumes[] = {1.0f, 0.37f};
+
+	bool ok = true;
+	for (uint32_t frames : kLengths) {
+		std::vector<float> left(frames), right(frames);
+		std::vector<float> expected(frames * kMaxChannels), actual(frames * kMaxChannels);
+		SignalGenerator gen_l(SignalGenerator::Kind::Noise, -6.0, 0.0, 48000, 3);
+		SignalGenerator gen_r(SignalGenerator::Kind::Noise, -6.0, 0.0, 48000, 4);
+		gen_l.fill(left.data(), frames);
+		gen_r.fill(right.data(), frames);
+
+		struct Case {
+			const char *name;
+			uint32_t channels;
+			const float *planes[kMaxChannels];
+		};
+		const Case cases[] = {
+			{"mono", 1, {left.data()}},
+			{"stereo", 2, {left.data(), right.data()}},
+			{"stereo, one plane", 2, {left.data(), nullptr}},
+			{"7.1", 8,
+			 {left.data(), right.data(), left.data(), right.data(), left.data(), right.data(), left.data(),
+			  right.data()}},
+		};
+
+		for (float volume : kVolumes) {
+			for (const Case &c : cases) {
+				const size_t bytes = static_cast<size_t>(frames) * c.channels * sizeof(float);
+				std::fill(actual.begin(), actual.end(), 1.0f); // Silence must be written, not assumed
+				const BlockStats ref = kernels::capture_planes(SimdLevel::Scalar, c.planes, c.channels,
+									       expected.data(), frames, volume);
+				for (SimdLevel level : kSimdLevels) {
+					if (!simd_level_supported(level)) {
+						continue;
+					}
+					const BlockStats got = kernels::capture_planes(level, c.planes, c.channels,
+										       actual.data(), frames, volume);
+					const bool match =
+						std::memcmp(expected.data(), actual.data(), bytes) == 0 &&
+						got.peak == ref.peak &&
+						std::fabs(got.sum_squares - ref.sum_squares) <= 1e-12 * ref.sum_squares;
+					if (!match) {
+						std::fprintf(stderr, "capture_%s mismatch (%u frames, %s, volume %.2f)\n",
+							     simd_level_name(level), frames, c.name, volume);
+						ok = false;
+					}
+				}
+
+				// Voice capture split at VAD hop ends, on every level (hop 7 leaves pieces shorter than
+				// a vector, hop 61 needs more than kMaxPieces pieces at 1023 frames: left unsplit)
+				for (SimdLevel level : kSimdLevels) {
+					for (uint32_t hop : {480u, 97u, 7u, 61u}) {
+						if (simd_level_supported(level) &&
+						    !check_hop_split(level, c.planes, c.channels, frames, volume, hop,
+								     expected.data(), ref, actual.data())) {
+							std::fprintf(stderr,
+								     "capture_%s hop split mismatch "
+								     "(%u frames, %s, hop %u)\n",
+								     simd_level_name(level), frames, c.name, hop);
+							ok = false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	Options opts;
+	if (!parse_options(argc, argv, opts)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (!check_capture_kernels()) {
+		return 1;
+	}
+
+	if (opts.csv) {
+		std::printf("kernel,layout,align,block,ns_per_block,ns_per_sample,cycles_per_block\n");
+	} else {
+		std::printf("%-16s %-7s %5s %6s %12s %10s %12s\n", "kernel", "layout", "align", "block", "ns/block",
+			    "ns/sample", "cycles/block");
+	}
+
+	for (uint32_t block : opts.block_sizes) {
+		run_block(opts, block);
+	}
+
+	return 0;
+}
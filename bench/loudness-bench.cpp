@@ -0,0 +1,676 @@
+// LoudnessMeter validation and cost against libebur128
+//
+// Feeds identical signals to LoudnessMeter and a mono libebur128 state, compares momentary and short-term
+// loudness at every 100 ms boundary (where both are defined over the same samples) and times the per-block
+// update and the loudness query of each. Exits with status 1 if any value differs by more than
+// --tolerance LU, so it can serve as a regression check for the native engine.
+//
+// The second table runs the analyzer's stream layout (voice, BGM, mix and 8 sources, each fed blocks of a
+// different length) through KWeightingBank on every SIMD level this CPU supports and checks it against
+// independent LoudnessMeter::add_frames streams.
+//
+// The third table checks TruePeakDetector on tones whose true peak is known: each SIMD level must match the
+// scalar kernel exactly and read within kTruePeakTolerance of the analytic peak, including a quarter-rate
+// tone whose samples all sit 3 dB below it.
+//
+// The fourth table runs the same 17 streams in multichannel layouts (one lane per channel, weighted with
+// channel_weight()) through KWeightingBank at 48 kHz and checks every stream against a libebur128 state with
+// the matching channel map, so the BS.1770 channel weights and the LFE exclusion are covered too.
+//
+// The fifth table feeds a long programme with level changes to a LoudnessMeter with a ProgrammeLoudness attached
+// and compares the integrated loudness and loudness range with libebur128 (which keeps every block) once a
+// minute; they must agree within the histogram resolution.
+//
+// The last table fills a WarmupWindow (the background history of a deselected source) in each layout, seeds a
+// fresh LoudnessMeter from it at every 100 ms boundary past 3 s and checks that the seeded short-term loudness
+// matches libebur128 fed the same audio. It also seeds / merges the window into meters with a ProgrammeLoudness
+// attached and checks that their integrated loudness and LRA match meters that never saw the seed, then times
+// WarmupWindow::add() per frame.
+
+#include "bench-common.h"
+
+#include "channel-layout.h"
+#include "k-weighting.h"
+#include "loudness-meter.h"
+#include "programme-loudness.h"
+#include "true-peak.h"
+#include "warmup-window.h"
+
+#include <ebur128.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace lbm;
+using namespace lbm::bench;
+
+namespace {
+
+struct Options {
+	std::vector<uint32_t> sample_rates{44100, 48000, 96000};
+	std::vector<uint32_t> block_sizes{480, 1024};
+	double seconds{20.0};
+	double tolerance{0.001};
+};
+
+void print_usage(const char *argv0)
+{
+	std::printf("Usage: %s [options]\n"
+		    "  --sample-rates LIST   comma-separated sample rates (default 44100,48000,96000)\n"
+		    "  --block-sizes LIST    comma-separated block sizes (default 480,1024)\n"
+		    "  --seconds N           audio seconds per case (default 20)\n"
+		    "  --tolerance LU        maximum allowed deviation from libebur128 (default 0.001)\n",
+		    argv0);
+}
+
+bool parse_options(int argc, char **argv, Options &opts)
+{
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (std::strcmp(arg, "--sample-rates") == 0 && value) {
+			opts.sample_rates = parse_u32_list(value);
+		} else if (std::strcmp(arg, "--block-sizes") == 0 && value) {
+			opts.block_sizes = parse_u32_list(value);
+		} else if (std::strcmp(arg, "--seconds") == 0 && value) {
+			opts.seconds = std::atof(value);
+		} else if (std::strcmp(arg, "--tolerance") == 0 && value) {
+			opts.tolerance = std::atof(value);
+		} else {
+			return false;
+		}
+		++i;
+	}
+	return !opts.sample_rates.empty() && !opts.block_sizes.empty() && opts.seconds > 0.0;
+}
+
+// Test programme: tone and noise sections with level steps and silent gaps
+void fill_signal(std::vector<float> &signal, uint32_t sample_rate)
+{
+	SignalGenerator tone(SignalGenerator::Kind::Tone, -18.0, 997.0, sample_rate);
+	SignalGenerator noise(SignalGenerator::Kind::Noise, -24.0, 0.0, sample_rate);
+	SignalGenerator bass(SignalGenerator::Kind::Tone, -12.0, 60.0, sample_rate);
+
+	const size_t section = sample_rate * 7 / 10; // not a multiple of 100 ms
+	for (size_t pos = 0; pos < signal.size(); pos += section) {
+		const uint32_t frames = static_cast<uint32_t>(std::min(section, signal.size() - pos));
+		switch ((pos / section) % 4) {
+		case 0:
+			tone.fill(signal.data() + pos, frames);
+			break;
+		case 1:
+			noise.fill(signal.data() + pos, frames);
+			break;
+		case 2:
+			bass.fill(signal.data() + pos, frames);
+			break;
+		default:
+			std::fill(signal.begin() + pos, signal.begin() + pos + frames, 0.0f);
+			break;
+		}
+	}
+}
+
+// Annex 2 filter passband ripple plus what 4x oversampling can miss below 0.4 fs
+constexpr double kTruePeakTolerance = 0.2;
+
+// Width of a ProgrammeLoudness histogram bin
+constexpr double kProgrammeTolerance = 0.1;
+
+// Difference in LU; anything below the BS.1770 absolute gate (-70 LUFS) reads as silence
+double deviation(double a, double b)
+{
+	return std::fabs(std::max(a, -70.0) - std::max(b, -70.0));
+}
+
+bool run_case(const Options &opts, uint32_t sample_rate, uint32_t block)
+{
+	std::vector<float> signal(static_cast<size_t>(opts.seconds * sample_rate));
+	fill_signal(signal, sample_rate);
+
+	// Accuracy: query both at every sub-block boundary
+	LoudnessMeter meter(sample_rate);
+	ebur128_state *state = ebur128_init(1, sample_rate, EBUR128_MODE_S);
+	ebur128_set_channel(state, 0, EBUR128_CENTER);
+
+	const size_t sub_block = (sample_rate + 5) / 10;
+	double max_momentary = 0.0;
+	double max_shortterm = 0.0;
+	size_t checks = 0;
+	for (size_t pos = 0; pos < signal.size();) {
+		// Split each block at sub-block boundaries
+		const size_t to_boundary = sub_block - pos % sub_block;
+		const size_t n = std::min({static_cast<size_t>(block - pos % block), to_boundary, signal.size() - pos});
+		meter.add_frames(signal.data() + pos, n);
+		ebur128_add_frames_float(state, signal.data() + pos, n);
+		pos += n;
+
+		if (pos % sub_block == 0) {
+			double ref_m = -HUGE_VAL, ref_s = -HUGE_VAL;
+			ebur128_loudness_momentary(state, &ref_m);
+			ebur128_loudness_shortterm(state, &ref_s);
+			max_momentary = std::max(max_momentary, deviation(meter.momentary(), ref_m));
+			max_shortterm = std::max(max_shortterm, deviation(meter.shortterm(), ref_s));
+			++checks;
+		}
+	}
+	ebur128_destroy(&state);
+
+	// Cost: block update + one short-term query per block, as the analyzer does
+	double sink = 0.0;
+	auto start = Clock::now();
+	LoudnessMeter timed_meter(sample_rate);
+	for (size_t pos = 0; pos + block <= signal.size(); pos += block) {
+		timed_meter.add_frames(signal.data() + pos, block);
+		sink += timed_meter.shortterm();
+	}
+	const double native_s = seconds_since(start);
+
+	state = ebur128_init(1, sample_rate, EBUR128_MODE_S);
+	ebur128_set_channel(state, 0, EBUR128_CENTER);
+	start = Clock::now();
+	for (size_t pos = 0; pos + block <= signal.size(); pos += block) {
+		double lufs = 0.0;
+		ebur128_add_frames_float(state, signal.data() + pos, block);
+		ebur128_loudness_shortterm(state, &lufs);
+		sink += lufs;
+	}
+	const double ebur_s = seconds_since(start);
+	ebur128_destroy(&state);
+	do_not_optimize(sink);
+
+	const bool ok = max_momentary <= opts.tolerance && max_shortterm <= opts.tolerance;
+	std::printf("%6u %6u %7zu %12.2e %12.2e %10.1f %10.1f %8.1fx  %s\n", sample_rate, block, checks,
+		    max_momentary, max_shortterm, native_s * 1e3, ebur_s * 1e3, native_s > 0.0 ? ebur_s / native_s : 0.0,
+		    ok ? "ok" : "FAIL");
+	return ok;
+}
+
+// KWeightingBank with `level` vs one scalar LoudnessMeter per stream
+bool run_bank_case(const Options &opts, SimdLevel level, uint32_t sample_rate, uint32_t block)
+{
+	constexpr size_t kStreams = 17; // LoudnessAnalyzer: voice, BGM, mix + kMaxBgmSources + kMaxOutputTracks
+	std::vector<float> signal(static_cast<size_t>(opts.seconds * sample_rate));
+	fill_signal(signal, sample_rate);
+
+	// Stream l starts at its own offset and takes shorter blocks, so lanes drift apart
+	size_t offsets[kStreams], blocks[kStreams];
+	for (size_t l = 0; l < kStreams; ++l) {
+		offsets[l] = l * sample_rate / 7;
+		blocks[l] = std::max<size_t>(1, block - l * block / 16);
+	}
+	const size_t steps = (signal.size() - offsets[kStreams - 1]) / block;
+
+	KWeightingBank bank;
+	bank.set_simd_level(level);
+	bank.set_sample_rate(sample_rate);
+	std::vector<LoudnessMeter> meters(kStreams, LoudnessMeter(sample_rate));
+	std::vector<LoudnessMeter> reference(kStreams, LoudnessMeter(sample_rate));
+	for (size_t l = 0; l < kStreams; ++l) {
+		bank.bind(l, &meters[l]);
+	}
+
+	double max_momentary = 0.0;
+	double max_shortterm = 0.0;
+	for (size_t step = 0; step < steps; ++step) {
+		for (size_t l = 0; l < kStreams; ++l) {
+			const float *samples = signal.data() + offsets[l] + step * blocks[l];
+			bank.push(l, samples, blocks[l]);
+			reference[l].add_frames(samples, blocks[l]);
+		}
+		bank.flush();
+		for (size_t l = 0; l < kStreams; ++l) {
+			max_momentary = std::max(max_momentary, deviation(meters[l].momentary(), reference[l].momentary()));
+			max_shortterm = std::max(max_shortterm, deviation(meters[l].shortterm(), reference[l].shortterm()));
+		}
+	}
+
+	// Cost: one batch of all streams per step vs filtering each stream on its own
+	double sink = 0.0;
+	bank.set_sample_rate(sample_rate);
+	auto start = Clock::now();
+	for (size_t step = 0; step < steps; ++step) {
+		for (size_t l = 0; l < kStreams; ++l) {
+			bank.push(l, signal.data() + offsets[l] + step * blocks[l], blocks[l]);
+		}
+		bank.flush();
+		sink += meters[0].shortterm();
+	}
+	const double bank_s = seconds_since(start);
+
+	start = Clock::now();
+	for (size_t step = 0; step < steps; ++step) {
+		for (size_t l = 0; l < kStreams; ++l) {
+			reference[l].add_frames(signal.data() + offsets[l] + step * blocks[l], blocks[l]);
+		}
+		sink += reference[0].shortterm();
+	}
+	const double scalar_s = seconds_since(start);
+	do_not_optimize(sink);
+
+	const bool ok = max_momentary <= opts.tolerance && max_shortterm <= opts.tolerance;
+	std::printf("%-6s %6u %6u %7zu %12.2e %12.2e %10.1f %10.1f %8.1fx  %s\n", simd_level_name(level), sample_rate,
+		    block, kStreams, max_momentary, max_shortterm, bank_s * 1e3, scalar_s * 1e3,
+		    bank_s > 0.0 ? scalar_s / bank_s : 0.0, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+// libebur128 channel for each channel of `layout` (OBS order, see channel-layout.h)
+int ebur128_channel(ChannelLayout layout, uint32_t channel)
+{
+	static constexpr int kStereo[] = {EBUR128_LEFT, EBUR128_RIGHT};
+	static constexpr int k2_1[] = {EBUR128_LEFT, EBUR128_RIGHT, EBUR128_UNUSED};
+	static constexpr int k4_0[] = {EBUR128_LEFT, EBUR128_RIGHT, EBUR128_CENTER, EBUR128_Mp180};
+	static constexpr int k4_1[] = {EBUR128_LEFT, EBUR128_RIGHT, EBUR128_CENTER, EBUR128_UNUSED, EBUR128_Mp180};
+	static constexpr int k5_1[] = {EBUR128_LEFT,   EBUR128_RIGHT,         EBUR128_CENTER,
+				       EBUR128_UNUSED, EBUR128_LEFT_SURROUND, EBUR128_RIGHT_SURROUND};
+	static constexpr int k7_1[] = {EBUR128_LEFT,   EBUR128_RIGHT, EBUR128_CENTER, EBUR128_UNUSED,
+				       EBUR128_Mp135,  EBUR128_Mm135, EBUR128_Mp090,  EBUR128_Mm090};
+
+	switch (layout) {
+	case ChannelLayout::Stereo:
+		return kStereo[channel];
+	case ChannelLayout::Surround2_1:
+		return k2_1[channel];
+	case ChannelLayout::Surround4_0:
+		return k4_0[channel];
+	case ChannelLayout::Surround4_1:
+		return k4_1[channel];
+	case ChannelLayout::Surround5_1:
+		return k5_1[channel];
+	case ChannelLayout::Surround7_1:
+		return k7_1[channel];
+	default:
+		return EBUR128_CENTER;
+	}
+}
+
+// KWeightingBank with `level` on 17 streams in `layout` vs one libebur128 state per stream
+bool run_layout_case(const Options &opts, SimdLevel level, ChannelLayout layout, uint32_t sample_rate,
+		     uint32_t block)
+{
+	constexpr size_t kStreams = 17;
+	const uint32_t channels = channel_count(layout);
+	std::vector<float> signal(static_cast<size_t>(opts.seconds * sample_rate));
+	fill_signal(signal, sample_rate);
+
+	// Channel c of stream l reads the programme from offsets[l] + c * spread, so every channel carries
+	// different material and the planes of a block are `spread` samples apart in `signal`
+	const size_t spread = sample_rate / 37;
+	size_t offsets[kStreams];
+	for (size_t l = 0; l < kStreams; ++l) {
+		offsets[l] = l * channels * spread;
+	}
+	const size_t length = signal.size() - offsets[kStreams - 1] - channels * spread;
+
+	double weights[kMaxChannels];
+	for (uint32_t c = 0; c < kMaxChannels; ++c) {
+		weights[c] = channel_weight(layout, c);
+	}
+
+	KWeightingBank bank;
+	bank.set_simd_level(level);
+	bank.set_sample_rate(sample_rate);
+	std::vector<LoudnessMeter> meters(kStreams, LoudnessMeter(sample_rate));
+	ebur128_state *states[kStreams];
+	for (size_t l = 0; l < kStreams; ++l) {
+		bank.bind(l * channels, &meters[l], weights, channels);
+		states[l] = ebur128_init(channels, sample_rate, EBUR128_MODE_S);
+		for (uint32_t c = 0; c < channels; ++c) {
+			ebur128_set_channel(states[l], c, ebur128_channel(layout, c));
+		}
+	}
+
+	// Accuracy: query both at every sub-block boundary
+	const size_t sub_block = (sample_rate + 5) / 10;
+	std::vector<float> interleaved(static_cast<size_t>(block) * channels);
+	double max_momentary = 0.0;
+	double max_shortterm = 0.0;
+	for (size_t pos = 0; pos < length;) {
+		const size_t to_boundary = sub_block - pos % sub_block;
+		const size_t n = std::min({static_cast<size_t>(block - pos % block), to_boundary, length - pos});
+		for (size_t l = 0; l < kStreams; ++l) {
+			const float *samples = signal.data() + offsets[l] + pos;
+			bank.push(l * channels, samples, n, spread);
+			for (size_t i = 0; i < n; ++i) {
+				for (uint32_t c = 0; c < channels; ++c) {
+					interleaved[i * channels + c] = samples[c * spread + i];
+				}
+			}
+			ebur128_add_frames_float(states[l], interleaved.data(), n);
+		}
+		bank.flush();
+		pos += n;
+
+		if (pos % sub_block == 0) {
+			for (size_t l = 0; l < kStreams; ++l) {
+				double ref_m = -HUGE_VAL, ref_s = -HUGE_VAL;
+				ebur128_loudness_momentary(states[l], &ref_m);
+				ebur128_loudness_shortterm(states[l], &ref_s);
+				max_momentary = std::max(max_momentary, deviation(meters[l].momentary(), ref_m));
+				max_shortterm = std::max(max_shortterm, deviation(meters[l].shortterm(), ref_s));
+			}
+		}
+	}
+	for (ebur128_state *&state : states) {
+		ebur128_destroy(&state);
+	}
+
+	// Cost: one batch of every stream per block
+	double sink = 0.0;
+	bank.set_sample_rate(sample_rate);
+	auto start = Clock::now();
+	for (size_t pos = 0; pos + block <= length; pos += block) {
+		for (size_t l = 0; l < kStreams; ++l) {
+			bank.push(l * channels, signal.data() + offsets[l] + pos, block, spread);
+		}
+		bank.flush();
+		sink += meters[0].shortterm();
+	}
+	const double bank_s = seconds_since(start);
+	do_not_optimize(sink);
+
+	const bool ok = max_momentary <= opts.tolerance && max_shortterm <= opts.tolerance;
+	std::printf("%-6s %6s %6u %6u %7zu %12.2e %12.2e %10.1f  %s\n", simd_level_name(level),
+		    channel_layout_name(layout), sample_rate, block, kStreams * channels, max_momentary, max_shortterm,
+		    bank_s * 1e3, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+// TruePeakDetector with `level` vs the analytic true peak of -6 dBFS tones and vs the scalar kernel
+bool run_true_peak_case(const Options &opts, SimdLevel level, uint32_t sample_rate, uint32_t block)
+{
+	struct Tone {
+		double frequency;
+		double phase;
+	};
+	const double rate = static_cast<double>(sample_rate);
+	const Tone tones[] = {{997.0, 0.3}, {rate / 4.0, kTwoPi / 8.0}, {rate * 0.4, kTwoPi / 6.0}};
+	const double amplitude = 0.5;
+	const double expected = 20.0 * std::log10(amplitude);
+
+	double max_error = 0.0;      // dBTP vs analytic
+	double max_under_read = 0.0; // Sample peak vs analytic, for comparison
+	bool exact = true;
+	std::vector<float> signal(sample_rate);
+	for (const Tone &tone : tones) {
+		for (size_t n = 0; n < signal.size(); ++n) {
+			const double t = static_cast<double>(n) / rate;
+			signal[n] = static_cast<float>(amplitude * std::sin(kTwoPi * tone.frequency * t + tone.phase));
+		}
+
+		TruePeakDetector detector, reference;
+		detector.set_simd_level(level);
+		reference.set_simd_level(SimdLevel::Scalar);
+		float peak = 0.0f;
+		float sample_peak = 0.0f;
+		for (size_t pos = 0; pos < signal.size(); pos += block) {
+			const size_t frames = std::min<size_t>(block, signal.size() - pos);
+			const float got = detector.process(signal.data() + pos, frames);
+			exact = exact && got == reference.process(signal.data() + pos, frames);
+			peak = std::max(peak, got);
+			for (size_t n = pos; n < pos + frames; ++n) {
+				sample_peak = std::max(sample_peak, std::fabs(signal[n]));
+			}
+		}
+		max_error = std::max(max_error, std::fabs(TruePeakDetector::to_dbtp(peak) - expected));
+		max_under_read = std::max(max_under_read, expected - TruePeakDetector::to_dbtp(sample_peak));
+	}
+
+	// Cost on the loudness test programme
+	std::vector<float> programme(static_cast<size_t>(opts.seconds * sample_rate));
+	fill_signal(programme, sample_rate);
+	TruePeakDetector detector;
+	detector.set_simd_level(level);
+	float sink = 0.0f;
+	const auto start = Clock::now();
+	for (size_t pos = 0; pos < programme.size(); pos += block) {
+		const size_t frames = std::min<size_t>(block, programme.size() - pos);
+		sink = std::max(sink, detector.process(programme.data() + pos, frames));
+	}
+	const double elapsed = seconds_since(start);
+	do_not_optimize(sink);
+
+	const bool ok = exact && max_error <= kTruePeakTolerance;
+	const double ns_per_sample = elapsed * 1e9 / programme.size();
+	std::printf("%-6s %6u %6u %12.3f %12.3f %8s %10.2f  %s\n", simd_level_name(level), sample_rate, block,
+		    max_error, max_under_read, exact ? "yes" : "NO", ns_per_sample, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+// Integrated loudness and LRA from ProgrammeLoudness vs libebur128 over `minutes` of programme
+bool run_programme_case(uint32_t sample_rate, uint32_t block, uint32_t minutes)
+{
+	// The test programme with its level moved every 10 s, so the loudness range is wide
+	static constexpr double kOffsets[] = {0.0, -6.0, 3.0, -12.0, -3.0, 6.0, -9.0};
+	constexpr size_t kSegments = sizeof(kOffsets) / sizeof(kOffsets[0]);
+	const size_t segment = static_cast<size_t>(sample_rate) * 10;
+	std::vector<float> signal(static_cast<size_t>(sample_rate) * 60 * minutes);
+	fill_signal(signal, sample_rate);
+	for (size_t pos = 0; pos < signal.size(); ++pos) {
+		signal[pos] *= static_cast<float>(std::pow(10.0, kOffsets[(pos / segment) % kSegments] / 20.0));
+	}
+
+	LoudnessMeter meter(sample_rate);
+	ProgrammeLoudness programme;
+	meter.set_programme(&programme);
+	ebur128_state *state = ebur128_init(1, sample_rate, EBUR128_MODE_I | EBUR128_MODE_LRA);
+	ebur128_set_channel(state, 0, EBUR128_CENTER);
+
+	const size_t minute = static_cast<size_t>(sample_rate) * 60;
+	double max_integrated = 0.0;
+	double max_range = 0.0;
+	double integrated = -HUGE_VAL;
+	double range = 0.0;
+	double query_s = 0.0;
+	for (size_t pos = 0; pos < signal.size();) {
+		const size_t n = std::min({static_cast<size_t>(block), minute - pos % minute, signal.size() - pos});
+		meter.add_frames(signal.data() + pos, n);
+		ebur128_add_frames_float(state, signal.data() + pos, n);
+		pos += n;
+
+		if (pos % minute == 0) {
+			const auto start = Clock::now();
+			integrated = programme.integrated();
+			range = programme.range();
+			query_s += seconds_since(start);
+
+			double ref_i = -HUGE_VAL, ref_lra = 0.0;
+			ebur128_loudness_global(state, &ref_i);
+			ebur128_loudness_range(state, &ref_lra);
+			max_integrated = std::max(max_integrated, deviation(integrated, ref_i));
+			max_range = std::max(max_range, std::fabs(range - ref_lra));
+		}
+	}
+	ebur128_destroy(&state);
+
+	const bool ok = max_integrated <= kProgrammeTolerance && max_range <= kProgrammeTolerance;
+	std::printf("%6u %6u %7u %10.2f %10.2f %12.3f %12.3f %10.1f  %s\n", sample_rate, block, minutes, integrated,
+		    range, max_integrated, max_range, query_s * 1e6 / minutes, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+// WarmupWindow in `layout`: a meter seeded from it vs libebur128 fed continuously
+bool run_warmup_case(const Options &opts, ChannelLayout layout, uint32_t sample_rate, uint32_t block)
+{
+	const uint32_t channels = channel_count(layout);
+	std::vector<float> signal(static_cast<size_t>(opts.seconds * sample_rate));
+	fill_signal(signal, sample_rate);
+
+	// Channel c reads the programme from c * spread, as in run_layout_case()
+	const size_t spread = sample_rate / 37;
+	const size_t length = signal.size() - channels * spread;
+
+	WarmupWindow window;
+	window.configure(sample_rate, layout);
+	ebur128_state *state = ebur128_init(channels, sample_rate, EBUR128_MODE_S);
+	for (uint32_t c = 0; c < channels; ++c) {
+		ebur128_set_channel(state, c, ebur128_channel(layout, c));
+	}
+
+	const size_t sub_block = (sample_rate + 5) / 10;
+	const float *planes[kMaxChannels]{};
+	std::vector<float> interleaved(static_cast<size_t>(block) * channels);
+	LoudnessMeter seeded(sample_rate);
+	double energies[LoudnessMeter::kShorttermBlocks];
+	double max_shortterm = 0.0;
+	size_t checks = 0;
+
+	// Programme side: from a third of the way in, `warmed` is seeded from the window and `merged` (fed all along)
+	// has the window merged in, as a source switch does to the voice and BGM meters; both are then fed channel 0
+	// like `fresh` (reset at the switch) and `plain` (fed all along). The programmes must not see the seeds.
+	LoudnessMeter warmed(sample_rate), fresh(sample_rate), merged(sample_rate), plain(sample_rate);
+	ProgrammeLoudness warmed_programme, fresh_programme, merged_programme, plain_programme;
+	warmed.set_programme(&warmed_programme);
+	fresh.set_programme(&fresh_programme);
+	merged.set_programme(&merged_programme);
+	plain.set_programme(&plain_programme);
+	const size_t switch_pos = length / 3 / sub_block * sub_block;
+	bool switched = false;
+
+	for (size_t pos = 0; pos < length;) {
+		const size_t n = std::min({static_cast<size_t>(block - pos % block), sub_block - pos % sub_block,
+					   length - pos});
+		for (uint32_t c = 0; c < channels; ++c) {
+			planes[c] = signal.data() + c * spread + pos;
+			for (size_t i = 0; i < n; ++i) {
+				interleaved[i * channels + c] = planes[c][i];
+			}
+		}
+		window.add(planes, static_cast<uint32_t>(n), 1.0f);
+		ebur128_add_frames_float(state, interleaved.data(), n);
+		merged.add_frames(planes[0], n);
+		plain.add_frames(planes[0], n);
+		if (switched) {
+			warmed.add_frames(planes[0], n);
+			fresh.add_frames(planes[0], n);
+		}
+		pos += n;
+
+		if (pos % sub_block == 0 && window.size() >= LoudnessMeter::kShorttermBlocks) {
+			// Oldest first, as LoudnessAnalyzer::warm_bgm_input() hands them over
+			for (size_t i = 0; i < LoudnessMeter::kShorttermBlocks; ++i) {
+				energies[i] = window.block(LoudnessMeter::kShorttermBlocks - 1 - i);
+			}
+			seeded.seed(energies, LoudnessMeter::kShorttermBlocks);
+			if (pos >= switch_pos && !switched) {
+				warmed.seed(energies, LoudnessMeter::kShorttermBlocks);
+				merged.merge(energies, LoudnessMeter::kShorttermBlocks);
+				switched = true;
+			}
+
+			double ref_s = -HUGE_VAL;
+			ebur128_loudness_shortterm(state, &ref_s);
+			max_shortterm = std::max(max_shortterm, deviation(seeded.shortterm(), ref_s));
+			++checks;
+		}
+	}
+	ebur128_destroy(&state);
+
+	const double max_integrated =
+		std::max(deviation(warmed_programme.integrated(), fresh_programme.integrated()),
+			 deviation(merged_programme.integrated(), plain_programme.integrated()));
+	const double max_range = std::max(std::fabs(warmed_programme.range() - fresh_programme.range()),
+					  std::fabs(merged_programme.range() - plain_programme.range()));
+
+	// Cost per frame of the capture-callback side
+	window.configure(sample_rate, layout);
+	auto start = Clock::now();
+	for (size_t pos = 0; pos + block <= length; pos += block) {
+		for (uint32_t c = 0; c < channels; ++c) {
+			planes[c] = signal.data() + c * spread + pos;
+		}
+		window.add(planes, block, 1.0f);
+	}
+	const double add_s = seconds_since(start);
+	do_not_optimize(window.block(0));
+
+	const bool ok = max_shortterm <= opts.tolerance && max_integrated <= opts.tolerance &&
+			max_range <= opts.tolerance;
+	std::printf("%6s %6u %6u %7zu %12.2e %12.2e %12.2e %10.1f  %s\n", channel_layout_name(layout), sample_rate,
+		    block, checks, max_shortterm, max_integrated, max_range,
+		    add_s * 1e9 / static_cast<double>(length / block * block), ok ? "ok" : "FAIL");
+	return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	Options opts;
+	if (!parse_options(argc, argv, opts)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	std::printf("LoudnessMeter state: %zu bytes per stream (libebur128 keeps 3 s of audio per stream)\n\n",
+		    sizeof(LoudnessMeter));
+	std::printf("%6s %6s %7s %12s %12s %10s %10s %9s\n", "rate", "block", "checks", "max_dM(LU)", "max_dS(LU)",
+		    "native_ms", "ebur_ms", "speedup");
+
+	bool ok = true;
+	for (uint32_t rate : opts.sample_rates) {
+		for (uint32_t block : opts.block_sizes) {
+			ok &= run_case(opts, rate, block);
+		}
+	}
+
+	std::printf("\nKWeightingBank (detected: %s)\n\n", simd_level_name(detect_simd_level()));
+	std::printf("%-6s %6s %6s %7s %12s %12s %10s %10s %9s\n", "simd", "rate", "block", "streams", "max_dM(LU)",
+		    "max_dS(LU)", "bank_ms", "scalar_ms", "speedup");
+	for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+		if (!simd_level_supported(level)) {
+			continue;
+		}
+		for (uint32_t rate : opts.sample_rates) {
+			for (uint32_t block : opts.block_sizes) {
+				ok &= run_bank_case(opts, level, rate, block);
+			}
+		}
+	}
+
+	std::printf("\nTruePeakDetector (tolerance %.2f dB)\n\n", kTruePeakTolerance);
+	std::printf("%-6s %6s %6s %12s %12s %8s %10s\n", "simd", "rate", "block", "max_dTP(dB)", "sample(dB)",
+		    "=scalar", "ns/sample");
+	for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+		if (!simd_level_supported(level)) {
+			continue;
+		}
+		for (uint32_t rate : opts.sample_rates) {
+			for (uint32_t block : opts.block_sizes) {
+				ok &= run_true_peak_case(opts, level, rate, block);
+			}
+		}
+	}
+
+	static constexpr ChannelLayout kLayouts[] = {ChannelLayout::Stereo, ChannelLayout::Surround5_1,
+						     ChannelLayout::Surround7_1};
+	std::printf("\nKWeightingBank multichannel vs libebur128\n\n");
+	std::printf("%-6s %6s %6s %6s %7s %12s %12s %10s\n", "simd", "layout", "rate", "block", "lanes", "max_dM(LU)",
+		    "max_dS(LU)", "bank_ms");
+	for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+		if (!simd_level_supported(level)) {
+			continue;
+		}
+		for (ChannelLayout layout : kLayouts) {
+			ok &= run_layout_case(opts, level, layout, 48000, opts.block_sizes.front());
+		}
+	}
+
+	std::printf("\nProgrammeLoudness vs libebur128 (tolerance %.1f LU, %zu bytes per stream)\n\n",
+		    kProgrammeTolerance, sizeof(ProgrammeLoudness));
+	std::printf("%6s %6s %7s %10s %10s %12s %12s %10s\n", "rate", "block", "minutes", "I(LUFS)", "LRA(LU)",
+		    "max_dI(LU)", "max_dLRA(LU)", "query_us");
+	ok &= run_programme_case(48000, opts.block_sizes.front(), 10);
+
+	static constexpr ChannelLayout kWarmupLayouts[] = {ChannelLayout::Mono, ChannelLayout::Stereo,
+							   ChannelLayout::Surround5_1};
+	std::printf("\nWarmupWindow seed vs libebur128 (%zu bytes per source)\n\n", sizeof(WarmupWindow));
+	std::printf("%6s %6s %6s %7s %12s %12s %12s %10s\n", "layout", "rate", "block", "checks", "max_dS(LU)",
+		    "dI_seed(LU)", "dLRA_seed", "ns/frame");
+	for (ChannelLayout layout : kWarmupLayouts) {
+		ok &= run_warmup_case(opts, layout, 48000, opts.block_sizes.front());
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+// Synthetic-stream throughput benchmark for LoudnessAnalyzer
+//
+// Drives push_voice_frame / push_bgm_frame (and push_track_frame with --tracks) with generated signals and reports:
+//   - throughput: frames/sec and samples/sec when the worker is flooded
+//   - worker CPU time per second of audio
+//   - per-block latency (push -> processed by worker) when paced at realtime
+//   - heap allocations during the throughput run (the steady state, VAD releases included, should make none)
+
+#include "bench-common.h"
+
+#include "loudness-analyzer.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+
+using namespace lbm;
+using namespace lbm::bench;
+
+// Heap allocations on any thread (replaces the global operator new for this program)
+static std::atomic<uint64_t> g_allocations{0};
+
+void *operator new(std::size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace {
+
+struct Options {
+	std::vector<uint32_t> block_sizes{256, 480, 1024, 4096};
+	std::vector<uint32_t> sample_rates{48000};
+	double seconds{60.0};        // audio duration for the throughput phase
+	double latency_seconds{2.0}; // audio duration for the realtime-paced latency phase
+	SignalGenerator::Kind bgm_kind{SignalGenerator::Kind::Noise};
+	bool voice_bursts{false}; // 2 s of voice, 1 s of silence: the VAD releases 20 times a minute
+	int tracks{0};            // Output tracks measured alongside (noise, -23 dBFS)
+};
+
+void print_usage(const char *argv0)
+{
+	std::printf("Usage: %s [options]\n"
+		    "  --block-sizes LIST     comma-separated block sizes (default 256,480,1024,4096)\n"
+		    "  --sample-rates LIST    comma-separated sample rates (default 48000)\n"
+		    "  --seconds N            audio seconds per throughput run (default 60)\n"
+		    "  --latency-seconds N    audio seconds per latency run, 0 to skip (default 2)\n"
+		    "  --bgm tone|noise       BGM test signal (default noise)\n"
+		    "  --voice steady|bursts  voice always on, or 2 s on / 1 s off (default steady)\n"
+		    "  --tracks N             also measure N output tracks, 0..6 (default 0)\n",
+		    argv0);
+}
+
+bool parse_options(int argc, char **argv, Options &opts)
+{
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+			return false;
+		} else if (std::strcmp(arg, "--block-sizes") == 0 && value) {
+			opts.block_sizes = parse_u32_list(value);
+			++i;
+		} else if (std::strcmp(arg, "--sample-rates") == 0 && value) {
+			opts.sample_rates = parse_u32_list(value);
+			++i;
+		} else if (std::strcmp(arg, "--seconds") == 0 && value) {
+			opts.seconds = std::atof(value);
+			++i;
+		} else if (std::strcmp(arg, "--latency-seconds") == 0 && value) {
+			opts.latency_seconds = std::atof(value);
+			++i;
+		} else if (std::strcmp(arg, "--bgm") == 0 && value) {
+			opts.bgm_kind = (std::strcmp(value, "tone") == 0) ? SignalGenerator::Kind::Tone
+									  : SignalGenerator::Kind::Noise;
+			++i;
+		} else if (std::strcmp(arg, "--voice") == 0 && value) {
+			opts.voice_bursts = std::strcmp(value, "bursts") == 0;
+			++i;
+		} else if (std::strcmp(arg, "--tracks") == 0 && value) {
+			opts.tracks = std::atoi(value);
+			++i;
+		} else {
+			std::fprintf(stderr, "Unknown or incomplete option: %s\n", arg);
+			return false;
+		}
+	}
+
+	for (uint32_t block : opts.block_sizes) {
+		if (block == 0 || block > AudioFrame::kMaxSamples) {
+			std::fprintf(stderr, "Block size must be 1..%zu\n", AudioFrame::kMaxSamples);
+			return false;
+		}
+	}
+	if (opts.tracks < 0 || opts.tracks > LoudnessAnalyzer::kMaxTrackInputs) {
+		std::fprintf(stderr, "Track count must be 0..%d\n", LoudnessAnalyzer::kMaxTrackInputs);
+		return false;
+	}
+	return !opts.block_sizes.empty() && !opts.sample_rates.empty();
+}
+
+// Push a frame, yielding until the queue accepts it
+template<typename PushFn> void push_blocking(PushFn push)
+{
+	while (!push()) {
+		std::this_thread::yield();
+	}
+}
+
+void wait_processed(const LoudnessAnalyzer &analyzer, uint64_t target)
+{
+	while (analyzer.processed_frames() < target) {
+		std::this_thread::yield();
+	}
+}
+
+void run_case(const Options &opts, uint32_t sample_rate, uint32_t block)
+{
+	auto analyzer_ptr = std::make_unique<LoudnessAnalyzer>();
+	LoudnessAnalyzer &analyzer = *analyzer_ptr;
+	analyzer.set_sample_rate(sample_rate);
+	const int bgm_input = analyzer.add_bgm_input();
+	for (int t = 0; t < opts.tracks; ++t) {
+		analyzer.add_track_input(t);
+	}
+	analyzer.start();
+
+	// Voice: 220 Hz tone at -20 dBFS (keeps the VAD active so the full voice + mix path runs), or the same in
+	// bursts so every pause releases the VAD and resets the voice and mix meters
+	const uint64_t burst_period = 3ull * sample_rate;
+	const uint64_t burst_length = 2ull * sample_rate;
+	SignalGenerator voice_gen(SignalGenerator::Kind::Tone, -20.0, 220.0, sample_rate);
+	SignalGenerator bgm_gen(opts.bgm_kind, -30.0, 1000.0, sample_rate, 0xBADC0FFEu);
+
+	// Every track carries the same program; each is still filtered and measured separately
+	SignalGenerator track_gen(SignalGenerator::Kind::Noise, -23.0, 1000.0, sample_rate, 0x7EA7u);
+	const uint64_t streams = 2 + static_cast<uint64_t>(opts.tracks);
+
+	std::vector<float> voice(block);
+	std::vector<float> bgm(block);
+	std::vector<float> track(block);
+	auto push_tracks = [&] {
+		track_gen.fill(track.data(), block);
+		for (int t = 0; t < opts.tracks; ++t) {
+			push_blocking([&] { return analyzer.push_track_frame(t, track.data(), block); });
+		}
+	};
+
+	// === Throughput (flooded) ===
+	const uint64_t blocks = static_cast<uint64_t>(opts.seconds * sample_rate / block);
+	uint64_t base = analyzer.processed_frames();
+
+	const double proc_cpu_start = process_cpu_seconds();
+	const double main_cpu_start = thread_cpu_seconds();
+	const uint64_t allocations_start = g_allocations.load(std::memory_order_relaxed);
+	const auto wall_start = Clock::now();
+
+	for (uint64_t n = 0; n < blocks; ++n) {
+		voice_gen.fill(voice.data(), block);
+		if (opts.voice_bursts && (n * block) % burst_period >= burst_length) {
+			std::fill(voice.begin(), voice.end(), 0.0f);
+		}
+		bgm_gen.fill(bgm.data(), block);
+		push_blocking([&] { return analyzer.push_voice_frame(voice.data(), block); });
+		push_blocking([&] { return analyzer.push_bgm_frame(bgm_input, bgm.data(), block); });
+		push_tracks();
+	}
+	wait_processed(analyzer, base + blocks * streams);
+
+	const double wall = seconds_since(wall_start);
+	const uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - allocations_start;
+	const double main_cpu = thread_cpu_seconds() - main_cpu_start;
+	const double worker_cpu = std::max(0.0, (process_cpu_seconds() - proc_cpu_start) - main_cpu);
+	const double audio_seconds = static_cast<double>(blocks) * block / sample_rate;
+
+	// === Latency (paced at realtime) ===
+	std::vector<double> latencies_us;
+	const uint64_t latency_blocks = static_cast<uint64_t>(opts.latency_seconds * sample_rate / block);
+	latencies_us.reserve(latency_blocks);
+
+	const auto period = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(static_cast<double>(block) / sample_rate));
+	auto deadline = Clock::now();
+	base = analyzer.processed_frames();
+
+	for (uint64_t n = 0; n < latency_blocks; ++n) {
+		voice_gen.fill(voice.data(), block);
+		bgm_gen.fill(bgm.data(), block);
+
+		deadline += period;
+		std::this_thread::sleep_until(deadline);
+
+		const auto t0 = Clock::now();
+		push_blocking([&] { return analyzer.push_voice_frame(voice.data(), block); });
+		push_blocking([&] { return analyzer.push_bgm_frame(bgm_input, bgm.data(), block); });
+		push_tracks();
+		base += streams;
+		wait_processed(analyzer, base);
+		latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+	}
+
+	analyzer.stop();
+
+	const LatencySummary lat = summarize(std::move(latencies_us));
+	const double frames_per_sec = (blocks * streams) / wall;
+	std::printf("%6u %6u %12.0f %14.0f %9.1fx %10.3f %9.3f%% %7llu %9.1f %9.1f %9.1f %9.1f\n", sample_rate, block,
+		    frames_per_sec, frames_per_sec * block, audio_seconds / wall, worker_cpu,
+		    100.0 * worker_cpu / audio_seconds, static_cast<unsigned long long>(allocations), lat.mean_us,
+		    lat.p50_us, lat.p99_us, lat.max_us);
+	std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	Options opts;
+	if (!parse_options(argc, argv, opts)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	std::printf("Voice: tone -20 dBFS%s, BGM: %s -30 dBFS, %d output track(s), %.1f s throughput / %.1f s latency "
+		    "per case\n",
+		    opts.voice_bursts ? " (2 s on / 1 s off)" : "",
+		    opts.bgm_kind == SignalGenerator::Kind::Tone ? "tone" : "noise", opts.tracks, opts.seconds,
+		    opts.latency_seconds);
+	std::printf("%6s %6s %12s %14s %10s %10s %10s %7s %9s %9s %9s %9s\n", "rate", "block", "frames/s",
+		    "samples/s", "realtime", "worker_s", "cpu/audio", "allocs", "lat_mean", "lat_p50", "lat_p99",
+		    "lat_max");
+	std::printf("%6s %6s %12s %14s %10s %10s %10s %7s %9s %9s %9s %9s\n", "", "", "", "", "", "", "", "", "us",
+		    "us", "us", "us");
+
+	for (uint32_t sample_rate : opts.sample_rates) {
+		for (uint32_t block : opts.block_sizes) {
+			run_case(opts, sample_rate, block);
+		}
+	}
+
+	return 0;
+}
@@ -1,27 +1,25 @@
 #include "audio-capture.h"
 #include "audio-frame.h"
+#include "audio-kernels.h"
 
 #include <algorithm>
 #include <cstring>
+#include <thread>
 
 namespace lbm {
 
-thread_local std::vector<float> AudioCaptureManager::downmix_buffer_;
-
 AudioCaptureManager::AudioCaptureManager(LoudnessAnalyzer &analyzer) : analyzer_(analyzer) {}
 
 AudioCaptureManager::~AudioCaptureManager()
 {
 	unregister_voice_callback();
 
-	std::lock_guard<std::mutex> lock(mutex_);
-	for (auto &bgm : bgm_sources_) {
-		if (bgm.source) {
-			obs_source_remove_audio_capture_callback(bgm.source, bgm_audio_callback, this);
-			obs_source_release(bgm.source);
-		}
+	clear_bgm_sources();
+	set_warmup_enabled(false);
+	for (int track = 0; track < LoudnessAnalyzer::kMaxTrackInputs; ++track) {
+		set_output_track(track, false);
 	}
-	bgm_sources_.clear();
+	delete bgm_routes_.exchange(nullptr);
 }
 
 void AudioCaptureManager::set_voice_source(const std::string &source_name)
@@ -32,8 +30,17 @@ void AudioCaptureManager::set_voice_source(const std::string &source_name)
 		return;
 	}
 
+	if (voice_source_) {
+		add_warmup_source(voice_source_, voice_source_name_);
+	}
 	unregister_voice_callback();
 	voice_source_name_ = source_name;
+
+	// Seed the voice window before the new source's first block is queued; with the old callback gone, the
+	// analyzer also drops the old source's blocks still queued
+	if (std::unique_ptr<WarmupWindow> window = take_warmup_source(source_name)) {
+		analyzer_.warm_voice(*window);
+	}
 	register_voice_callback();
 }
 
@@ -65,12 +72,27 @@ void AudioCaptureManager::add_bgm_source(const std::string &source_name)
 		return;
 	}
 
+	// Each source gets its own analyzer queue (single producer per queue)
+	int input = analyzer_.add_bgm_input();
+	if (input < 0) {
+		obs_source_release(source);
+		return;
+	}
+
+	// Seed the input's window before its first block is queued
+	if (std::unique_ptr<WarmupWindow> window = take_warmup_source(source_name)) {
+		analyzer_.warm_bgm_input(input, *window);
+	}
+
 	BGMSource bgm;
 	bgm.name = source_name;
 	bgm.source = source;
+	bgm.input = input;
 
+	// Callbacks are dropped until the route is published
 	obs_source_add_audio_capture_callback(source, bgm_audio_callback, this);
 	bgm_sources_.push_back(bgm);
+	publish_bgm_routes();
 }
 
 void AudioCaptureManager::remove_bgm_source(const std::string &source_name)
@@ -81,11 +103,13 @@ void AudioCaptureManager::remove_bgm_source(const std::string &source_name)
 			       [&source_name](const BGMSource &bgm) { return bgm.name == source_name; });
 
 	if (it != bgm_sources_.end()) {
-		if (it->source) {
-			obs_source_remove_audio_capture_callback(it->source, bgm_audio_callback, this);
-			obs_source_release(it->source);
-		}
+		BGMSource bgm = *it;
 		bgm_sources_.erase(it);
+
+		// Unroute first so no callback writes the input while it is retired
+		publish_bgm_routes();
+		add_warmup_source(bgm.source, bgm.name);
+		release_bgm_source(bgm);
 	}
 }
 
@@ -93,13 +117,158 @@ void AudioCaptureManager::clear_bgm_sources()
 {
 	std::lock_guard<std::mutex> lock(mutex_);
 
-	for (auto &bgm : bgm_sources_) {
-		if (bgm.source) {
-			obs_source_remove_audio_capture_callback(bgm.source, bgm_audio_callback, this);
-			obs_source_release(bgm.source);
+	std::vector<BGMSource> removed;
+	removed.swap(bgm_sources_);
+	publish_bgm_routes();
+
+	for (const auto &bgm : removed) {
+		release_bgm_source(bgm);
+	}
+}
+
+void AudioCaptureManager::publish_bgm_routes()
+{
+	auto *table = new BGMRoutingTable();
+	for (const auto &bgm : bgm_sources_) {
+		if (bgm.source && bgm.input >= 0 && table->count < LoudnessAnalyzer::kMaxBgmInputs) {
+			table->routes[table->count++] = BGMRoute{bgm.source, bgm.input};
+		}
+	}
+
+	const BGMRoutingTable *old = bgm_routes_.exchange(table);
+
+	// Grace period: wait for callbacks that may still hold the old table (UI thread only)
+	while (route_readers_.load() != 0) {
+		std::this_thread::yield();
+	}
+	delete old;
+}
+
+void AudioCaptureManager::release_bgm_source(const BGMSource &bgm)
+{
+	if (bgm.source) {
+		obs_source_remove_audio_capture_callback(bgm.source, bgm_audio_callback, this);
+		obs_source_release(bgm.source);
+	}
+	analyzer_.remove_bgm_input(bgm.input);
+}
+
+void AudioCaptureManager::set_output_track(int track, bool enabled)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (track < 0 || track >= LoudnessAnalyzer::kMaxTrackInputs ||
+	    enabled == ((output_tracks_ & (1u << track)) != 0)) {
+		return;
+	}
+	if (!enabled) {
+		disconnect_output_track(track);
+		return;
+	}
+
+	audio_t *audio = obs_get_audio();
+	if (!audio) {
+		return;
+	}
+
+	// The track's queue exists before its first block arrives
+	if (!analyzer_.add_track_input(track)) {
+		return;
+	}
+	if (!audio_output_connect(audio, static_cast<size_t>(track), nullptr, track_audio_callback, this)) {
+		analyzer_.remove_track_input(track);
+		return;
+	}
+	output_tracks_ |= 1u << track;
+}
+
+uint32_t AudioCaptureManager::output_tracks() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return output_tracks_;
+}
+
+void AudioCaptureManager::disconnect_output_track(int track)
+{
+	// OBS calls the output callbacks under the lock audio_output_disconnect takes, so none is running after it
+	if (audio_t *audio = obs_get_audio()) {
+		audio_output_disconnect(audio, static_cast<size_t>(track), track_audio_callback, this);
+	}
+	analyzer_.remove_track_input(track);
+	output_tracks_ &= ~(1u << track);
+}
+
+void AudioCaptureManager::set_warmup_enabled(bool enabled)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	warmup_enabled_ = enabled;
+	if (!enabled) {
+		for (WarmupSource &warmup : warmup_sources_) {
+			release_warmup_source(warmup);
 		}
+		warmup_sources_.clear();
+	}
+}
+
+bool AudioCaptureManager::warmup_enabled() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return warmup_enabled_;
+}
+
+void AudioCaptureManager::add_warmup_source(obs_source_t *source, const std::string &name)
+{
+	if (!warmup_enabled_ || !source) {
+		return;
+	}
+
+	// Already warm (it was voice and BGM at once): just make it the most recent
+	auto it = std::find_if(warmup_sources_.begin(), warmup_sources_.end(),
+			       [&name](const WarmupSource &warmup) { return warmup.name == name; });
+	if (it != warmup_sources_.end()) {
+		std::rotate(warmup_sources_.begin(), it, it + 1);
+		return;
+	}
+
+	// Oldest out (allocated here on the UI thread, never in the callback)
+	if (warmup_sources_.size() == kMaxWarmupSources) {
+		release_warmup_source(warmup_sources_.back());
+		warmup_sources_.pop_back();
+	}
+
+	obs_source_t *ref = obs_source_get_ref(source);
+	if (!ref) {
+		return;
+	}
+	auto window = std::make_unique<WarmupWindow>();
+	window->configure(analyzer_.sample_rate(), analyzer_.channel_layout());
+	obs_source_add_audio_capture_callback(ref, warmup_audio_callback, window.get());
+	warmup_sources_.insert(warmup_sources_.begin(), WarmupSource{name, ref, std::move(window)});
+}
+
+std::unique_ptr<WarmupWindow> AudioCaptureManager::take_warmup_source(const std::string &name)
+{
+	auto it = std::find_if(warmup_sources_.begin(), warmup_sources_.end(),
+			       [&name](const WarmupSource &warmup) { return warmup.name == name; });
+	if (it == warmup_sources_.end()) {
+		return nullptr;
+	}
+
+	// Once the callback is removed the history is no longer written and can be read here
+	release_warmup_source(*it);
+	std::unique_ptr<WarmupWindow> window = std::move(it->window);
+	warmup_sources_.erase(it);
+	return window;
+}
+
+void AudioCaptureManager::release_warmup_source(WarmupSource &warmup)
+{
+	if (warmup.source) {
+		obs_source_remove_audio_capture_callback(warmup.source, warmup_audio_callback, warmup.window.get());
+		obs_source_release(warmup.source);
+		warmup.source = nullptr;
 	}
-	bgm_sources_.clear();
 }
 
 std::vector<std::string> AudioCaptureManager::bgm_source_names() const
@@ -114,6 +283,39 @@ std::vector<std::string> AudioCaptureManager::bgm_source_names() const
 	return names;
 }
 
+AudioCaptureManager::SourceTelemetry AudioCaptureManager::voice_telemetry() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return SourceTelemetry{voice_source_name_, analyzer_.voice_telemetry()};
+}
+
+std::vector<AudioCaptureManager::SourceTelemetry> AudioCaptureManager::bgm_telemetry() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::vector<SourceTelemetry> telemetry;
+	telemetry.reserve(bgm_sources_.size());
+	for (const auto &bgm : bgm_sources_) {
+		telemetry.push_back(SourceTelemetry{bgm.name, analyzer_.bgm_telemetry(bgm.input)});
+	}
+	return telemetry;
+}
+
+std::vector<AudioCaptureManager::SourceLoudness> AudioCaptureManager::bgm_loudness() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::vector<SourceLoudness> loudness;
+	loudness.reserve(bgm_sources_.size());
+	for (const auto &bgm : bgm_sources_) {
+		const BgmSourceResults &source = analyzer_.results().bgm_sources[bgm.input];
+		loudness.push_back(SourceLoudness{bgm.name, source.lufs.load(std::memory_order_relaxed),
+						  source.peak_dbfs.load(std::memory_order_relaxed),
+						  source.true_peak_dbtp.load(std::memory_order_relaxed)});
+	}
+	return loudness;
+}
+
 bool AudioCaptureManager::has_bgm_sources() const
 {
 	std::lock_guard<std::mutex> lock(mutex_);
@@ -157,6 +359,8 @@ void AudioCaptureManager::save_settings(obs_data_t *settings) const
 	}
 	obs_data_set_array(settings, "bgm_sources", bgm_array);
 	obs_data_array_release(bgm_array);
+
+	obs_data_set_int(settings, "output_tracks", output_tracks_);
 }
 
 void AudioCaptureManager::load_settings(obs_data_t *settings)
@@ -181,15 +385,58 @@ void AudioCaptureManager::load_settings(obs_data_t *settings)
 		}
 		obs_data_array_release(bgm_array);
 	}
+
+	// Load output tracks (bit t: track t + 1)
+	const uint32_t tracks = static_cast<uint32_t>(obs_data_get_int(settings, "output_tracks"));
+	for (int track = 0; track < LoudnessAnalyzer::kMaxTrackInputs; ++track) {
+		if (tracks & (1u << track)) {
+			set_output_track(track, true);
+		}
+	}
 }
 
 void AudioCaptureManager::voice_audio_callback(void *param, obs_source_t *source, const audio_data *audio, bool muted)
 {
-	if (!param || !audio || !audio->data[0] || muted) {
+	if (!param || !audio || !audio->data[0]) {
 		return;
 	}
 
-	if (audio->frames == 0 || audio->frames > AudioFrame::kMaxSamples) {
+	auto *self = static_cast<AudioCaptureManager *>(param);
+
+	// Get volume fader value (0.0 to 1.0+)
+	float volume = obs_source_get_volume(source);
+
+	// Record before filtering so replay sees every callback
+	self->record_callback(RecordedStream::Voice, source, audio, volume, muted);
+
+	if (audio->frames == 0) {
+		return;
+	}
+	if (muted || audio->frames > AudioFrame::kMaxSamples) {
+		self->analyzer_.count_voice_drop(muted ? DropReason::Muted : DropReason::Oversized, audio->frames);
+		return;
+	}
+
+	// Write straight into the analyzer's queue (dropped and counted if the worker is behind)
+	float *samples = self->analyzer_.reserve_voice_frame(audio->frames);
+	if (!samples) {
+		return;
+	}
+
+	// Copy the planes and apply the volume fader, measuring peak and energy in the same pass; the energy is also
+	// split at the VAD's hop ends so the worker does not read the samples again for it
+	HopEnergy hops = self->analyzer_.next_voice_hops();
+	const BlockStats stats = capture_planes(audio, self->analyzer_.channels(), samples, volume, &hops);
+
+	// Publish to analyzer (on the timeline the sync offset puts the source at)
+	self->analyzer_.commit_voice_frame(
+		audio->frames, stats,
+		TimelineClock::apply_sync_offset(audio->timestamp, obs_source_get_sync_offset(source)), &hops);
+}
+
+void AudioCaptureManager::bgm_audio_callback(void *param, obs_source_t *source, const audio_data *audio, bool muted)
+{
+	if (!param || !audio || !audio->data[0]) {
 		return;
 	}
 
@@ -198,41 +445,121 @@ void AudioCaptureManager::voice_audio_callback(void *param, obs_source_t *source
 	// Get volume fader value (0.0 to 1.0+)
 	float volume = obs_source_get_volume(source);
 
-	// Downmix to mono
-	downmix_buffer_.resize(audio->frames);
-	downmix_to_mono(audio, downmix_buffer_.data(), audio->frames);
+	// Record before filtering so replay sees every callback
+	self->record_callback(RecordedStream::BGM, source, audio, volume, muted);
+
+	if (audio->frames == 0) {
+		return;
+	}
 
-	// Apply volume fader
-	apply_volume(downmix_buffer_.data(), audio->frames, volume);
+	// Route to this source's analyzer input; the table stays valid until route_readers_ drops
+	self->route_readers_.fetch_add(1);
+	const BGMRoutingTable *table = self->bgm_routes_.load();
+	int input = -1;
+	if (table) {
+		for (size_t i = 0; i < table->count; ++i) {
+			if (table->routes[i].source == source) {
+				input = table->routes[i].input;
+				break;
+			}
+		}
+	}
 
-	// Push to analyzer
-	self->analyzer_.push_voice_frame(downmix_buffer_.data(), audio->frames);
+	// Unrouted sources (being added or removed) are ignored
+	if (input >= 0) {
+		if (muted || audio->frames > AudioFrame::kMaxSamples) {
+			self->analyzer_.count_bgm_drop(input, muted ? DropReason::Muted : DropReason::Oversized,
+						       audio->frames);
+		} else {
+			self->push_bgm_block(input, audio, volume, obs_source_get_sync_offset(source));
+		}
+	}
+	self->route_readers_.fetch_sub(1);
 }
 
-void AudioCaptureManager::bgm_audio_callback(void *param, obs_source_t *source, const audio_data *audio, bool muted)
+void AudioCaptureManager::warmup_audio_callback(void *param, obs_source_t *source, const audio_data *audio,
+						bool muted)
 {
-	if (!param || !audio || !audio->data[0] || muted) {
+	if (!param || !audio || !audio->data[0] || muted || audio->frames == 0) {
 		return;
 	}
 
-	if (audio->frames == 0 || audio->frames > AudioFrame::kMaxSamples) {
+	// Same planes and fader as a selected source, measured in place (nothing is queued)
+	auto *window = static_cast<WarmupWindow *>(param);
+	const float *planes[kMaxChannels]{};
+	for (uint32_t c = 0; c < channel_count(window->layout()) && c < MAX_AV_PLANES; ++c) {
+		planes[c] = reinterpret_cast<const float *>(audio->data[c]);
+	}
+	window->add(planes, audio->frames, obs_source_get_volume(source));
+}
+
+void AudioCaptureManager::track_audio_callback(void *param, size_t mix_idx, audio_data *audio)
+{
+	if (!param || !audio || !audio->data[0] || audio->frames == 0) {
 		return;
 	}
 
 	auto *self = static_cast<AudioCaptureManager *>(param);
+	const int track = static_cast<int>(mix_idx);
+	if (audio->frames > AudioFrame::kMaxSamples) {
+		self->analyzer_.count_track_drop(track, DropReason::Oversized, audio->frames);
+		return;
+	}
 
-	// Get volume fader value (0.0 to 1.0+)
-	float volume = obs_source_get_volume(source);
+	// Write straight into the analyzer's queue (dropped and counted if the worker is behind)
+	float *samples = self->analyzer_.reserve_track_frame(track, audio->frames);
+	if (!samples) {
+		return;
+	}
 
-	// Downmix to mono
-	downmix_buffer_.resize(audio->frames);
-	downmix_to_mono(audio, downmix_buffer_.data(), audio->frames);
+	// The mix is final: faders and mutes are already applied, so the planes are copied as they are
+	const BlockStats stats = capture_planes(audio, self->analyzer_.channels(), samples, 1.0f);
+	self->analyzer_.commit_track_frame(track, audio->frames, stats);
+}
 
-	// Apply volume fader
-	apply_volume(downmix_buffer_.data(), audio->frames, volume);
+void AudioCaptureManager::push_bgm_block(int input, const audio_data *audio, float volume, int64_t sync_offset)
+{
+	// Write straight into the analyzer's queue (dropped and counted if the worker is behind)
+	float *samples = analyzer_.reserve_bgm_frame(input, audio->frames);
+	if (!samples) {
+		return;
+	}
 
-	// Push to analyzer
-	self->analyzer_.push_bgm_frame(downmix_buffer_.data(), audio->frames);
+	// Copy the planes and apply the volume fader, measuring peak and energy in the same pass
+	const BlockStats stats = capture_planes(audio, analyzer_.channels(), samples, volume);
+
+	// Publish to analyzer (on the timeline the sync offset puts the source at)
+	analyzer_.commit_bgm_frame(input, audio->frames, stats,
+				   TimelineClock::apply_sync_offset(audio->timestamp, sync_offset));
+}
+
+bool AudioCaptureManager::start_recording(const std::string &path)
+{
+	return recorder_.start(path, analyzer_.sample_rate());
+}
+
+void AudioCaptureManager::stop_recording()
+{
+	recorder_.stop();
+}
+
+void AudioCaptureManager::record_callback(RecordedStream stream, obs_source_t *source, const audio_data *audio,
+					  float volume, bool muted)
+{
+	if (!recorder_.is_active()) {
+		return;
+	}
+
+	// Planes are contiguous from data[0]; count them to get the channel layout
+	const float *planes[MAX_AV_PLANES]{};
+	uint32_t channels = 0;
+	while (channels < MAX_AV_PLANES && audio->data[channels]) {
+		planes[channels] = reinterpret_cast<const float *>(audio->data[channels]);
+		++channels;
+	}
+
+	recorder_.record(stream, source, planes, channels, audio->frames, audio->timestamp,
+			 obs_source_get_sync_offset(source), volume, muted);
 }
 
 void AudioCaptureManager::register_voice_callback()
@@ -272,32 +599,17 @@ void AudioCaptureManager::unregister_bgm_callback(obs_source_t *source)
 	}
 }
 
-void AudioCaptureManager::downmix_to_mono(const audio_data *audio, float *out, uint32_t frames)
-{
-	const float *ch0 = reinterpret_cast<const float *>(audio->data[0]);
-	const float *ch1 = audio->data[1] ? reinterpret_cast<const float *>(audio->data[1]) : nullptr;
-
-	if (ch1) {
-		// Stereo -> mono (average)
-		for (uint32_t i = 0; i < frames; ++i) {
-			out[i] = (ch0[i] + ch1[i]) * 0.5f;
-		}
-	} else {
-		// Already mono
-		std::memcpy(out, ch0, frames * sizeof(float));
-	}
-}
-
-void AudioCaptureManager::apply_volume(float *samples, uint32_t frames, float volume)
+BlockStats AudioCaptureManager::capture_planes(const audio_data *audio, uint32_t channels, float *out, float volume,
+					       HopEnergy *hops)
 {
-	// Skip if volume is 1.0 (no change needed)
-	if (volume == 1.0f) {
-		return;
+	// Capture callbacks deliver the output layout the analyzer was configured with
+	const float *planes[kMaxChannels]{};
+	for (uint32_t c = 0; c < channels && c < MAX_AV_PLANES; ++c) {
+		planes[c] = reinterpret_cast<const float *>(audio->data[c]);
 	}
 
-	for (uint32_t i = 0; i < frames; ++i) {
-		samples[i] *= volume;
-	}
+	return hops ? kernels::capture_planes(planes, channels, out, audio->frames, volume, *hops)
+		    : kernels::capture_planes(planes, channels, out, audio->frames, volume);
 }
 
 } // namespace lbm
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "callback-recording.h"
 #include "loudness-analyzer.h"
+#include "warmup-window.h"
 
 #include <obs.h>
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -32,6 +35,34 @@ public:
 	std::vector<std::string> bgm_source_names() const;
 	bool has_bgm_sources() const;
 
+	// Pipeline telemetry (pushed/dropped blocks, queue lag) per selected source
+	struct SourceTelemetry {
+		std::string name;
+		StreamTelemetry stats;
+	};
+	SourceTelemetry voice_telemetry() const;
+	std::vector<SourceTelemetry> bgm_telemetry() const;
+
+	// Loudness of each selected BGM source before summing
+	struct SourceLoudness {
+		std::string name;
+		double lufs;
+		double peak_dbfs;
+		double true_peak_dbtp;
+	};
+	std::vector<SourceLoudness> bgm_loudness() const;
+
+	// Output tracks: measure OBS mixer track `track` (0 = track 1) as the outputs receive it, connected with
+	// audio_output_connect to obs_get_audio(); the whole program, after every fader and track assignment
+	void set_output_track(int track, bool enabled);
+	uint32_t output_tracks() const; // Bit t set while track t is measured
+
+	// Warm-up: keep listening to the last kMaxWarmupSources deselected voice / BGM sources, K-weighting them into
+	// a 100 ms energy history (WarmupWindow) in their capture callback, so a reselected source starts with a full
+	// short-term window instead of reading "--" for 3 s. Off by default; turning it off drops the histories.
+	void set_warmup_enabled(bool enabled);
+	bool warmup_enabled() const;
+
 	// Enumerate all audio-capable sources
 	static std::vector<std::string> enumerate_audio_sources();
 
@@ -39,10 +70,19 @@ public:
 	void save_settings(obs_data_t *settings) const;
 	void load_settings(obs_data_t *settings);
 
+	// Record every capture callback (planar audio, timestamp, volume, mute) for offline replay
+	bool start_recording(const std::string &path);
+	void stop_recording();
+	bool is_recording() const { return recorder_.is_active(); }
+
 private:
 	// Audio capture callbacks (static for OBS API)
 	static void voice_audio_callback(void *param, obs_source_t *source, const audio_data *audio, bool muted);
 	static void bgm_audio_callback(void *param, obs_source_t *source, const audio_data *audio, bool muted);
+	static void warmup_audio_callback(void *param, obs_source_t *source, const audio_data *audio, bool muted);
+
+	// Output mix callback (mix_idx is the analyzer track)
+	static void track_audio_callback(void *param, size_t mix_idx, audio_data *audio);
 
 	// Internal helpers
 	void register_voice_callback();
@@ -50,11 +90,18 @@ private:
 	void register_bgm_callback(obs_source_t *source);
 	void unregister_bgm_callback(obs_source_t *source);
 
-	// Downmix stereo to mono
-	static void downmix_to_mono(const audio_data *audio, float *out, uint32_t frames);
+	// Copy `channels` planes (plane c at out + c * frames) and apply the volume fader in one pass, returning the
+	// block's peak and energy (split at the hop ends in `hops`, if given); planes the block lacks are written as
+	// silence
+	static BlockStats capture_planes(const audio_data *audio, uint32_t channels, float *out, float volume,
+					 HopEnergy *hops = nullptr);
 
-	// Apply volume multiplier to samples
-	static void apply_volume(float *samples, uint32_t frames, float volume);
+	// Copy, apply the fader and queue one BGM block for the given analyzer input
+	void push_bgm_block(int input, const audio_data *audio, float volume, int64_t sync_offset);
+
+	// Forward a raw callback to the recorder (no-op unless recording)
+	void record_callback(RecordedStream stream, obs_source_t *source, const audio_data *audio, float volume,
+			     bool muted);
 
 	// Reference to analyzer
 	LoudnessAnalyzer &analyzer_;
@@ -67,14 +114,61 @@ private:
 	struct BGMSource {
 		std::string name;
 		obs_source_t *source{nullptr};
+		int input{-1}; // Analyzer BGM input index
 	};
 	std::vector<BGMSource> bgm_sources_;
 
+	// BGM routing table read by bgm_audio_callback without locking (RCU style)
+	// A table is immutable once published; readers announce themselves in route_readers_ so a
+	// replaced table is freed only after every callback that could have loaded it has finished.
+	struct BGMRoute {
+		const obs_source_t *source;
+		int input;
+	};
+	struct BGMRoutingTable {
+		size_t count{0};
+		BGMRoute routes[LoudnessAnalyzer::kMaxBgmInputs]{};
+	};
+	std::atomic<const BGMRoutingTable *> bgm_routes_{nullptr};
+	std::atomic<int> route_readers_{0};
+
+	// Publish a new routing table built from bgm_sources_ (mutex_ held)
+	// Returns once no audio callback can still be using the previous table
+	void publish_bgm_routes();
+
+	// Detach a BGM source from OBS and the analyzer (mutex_ held, source already unrouted)
+	void release_bgm_source(const BGMSource &bgm);
+
+	// Output tracks connected to obs_get_audio() (mutex_ held)
+	uint32_t output_tracks_{0};
+
+	// Disconnect a track from OBS and retire its analyzer input (mutex_ held)
+	void disconnect_output_track(int track);
+
+	// Recently deselected sources being warmed up, most recent first (mutex_ held)
+	struct WarmupSource {
+		std::string name;
+		obs_source_t *source{nullptr};
+		std::unique_ptr<WarmupWindow> window; // Callback parameter, so its address stays put
+	};
+	std::vector<WarmupSource> warmup_sources_;
+	bool warmup_enabled_{false};
+	static constexpr size_t kMaxWarmupSources = 4;
+
+	// Start warming up a source that was just deselected (takes its own reference)
+	void add_warmup_source(obs_source_t *source, const std::string &name);
+
+	// Stop warming up `name`; returns its history, or nullptr if it was not warm
+	std::unique_ptr<WarmupWindow> take_warmup_source(const std::string &name);
+
+	// Detach a warm-up source from OBS
+	static void release_warmup_source(WarmupSource &warmup);
+
 	// Mutex for source management (not audio callback)
 	mutable std::mutex mutex_;
 
-	// Temporary buffer for downmixing (avoid allocation in callback)
-	static thread_local std::vector<float> downmix_buffer_;
+	// Capture callback recorder (debug / regression corpus)
+	CallbackRecorder recorder_;
 };
 
 } // namespace lbm
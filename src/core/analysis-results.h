@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+
+namespace lbm {
+
+// Status for each judgment
+enum class Status { OK, WARN, BAD };
+
+// Maximum number of simultaneously selected BGM sources
+constexpr int kMaxBgmSources = 8;
+
+// Loudness of one BGM source before summing (lets the dock show which source dominates)
+struct BgmSourceResults {
+	std::atomic<double> lufs{-HUGE_VAL};
+	std::atomic<double> peak_dbfs{-HUGE_VAL};
+	std::atomic<double> true_peak_dbtp{-HUGE_VAL};
+
+	void reset()
+	{
+		lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		peak_dbfs.store(-HUGE_VAL, std::memory_order_relaxed);
+		true_peak_dbtp.store(-HUGE_VAL, std::memory_order_relaxed);
+	}
+};
+
+// OBS output mixer tracks (MAX_AUDIO_MIXES)
+constexpr int kMaxOutputTracks = 6;
+
+// Loudness of one OBS output track as the outputs receive it, measured whole (no VAD gate)
+struct TrackResults {
+	std::atomic<double> lufs{-HUGE_VAL};
+	std::atomic<double> integrated_lufs{-HUGE_VAL};
+	std::atomic<double> lra{0.0};
+	std::atomic<double> peak_dbfs{-HUGE_VAL};
+	std::atomic<double> true_peak_dbtp{-HUGE_VAL};
+	std::atomic<Status> clip_status{Status::OK};
+
+	void reset()
+	{
+		lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		integrated_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		lra.store(0.0, std::memory_order_relaxed);
+		peak_dbfs.store(-HUGE_VAL, std::memory_order_relaxed);
+		true_peak_dbtp.store(-HUGE_VAL, std::memory_order_relaxed);
+		clip_status.store(Status::OK, std::memory_order_relaxed);
+	}
+};
+
+// Analysis results shared between worker thread and UI thread
+// All members are atomic for thread-safe access
+// *_peak_dbfs: sample peak of the last block; *_true_peak_dbtp: BS.1770 true peak (4x oversampled) of the
+// blocks processed in the last update; *_integrated_lufs / *_lra: integrated loudness and loudness range since
+// the analyzer started (only the voice-active audio for voice and mix)
+struct AnalysisResults {
+	// Voice metrics
+	std::atomic<double> voice_lufs{-HUGE_VAL};
+	std::atomic<double> voice_peak_dbfs{-HUGE_VAL};
+	std::atomic<double> voice_true_peak_dbtp{-HUGE_VAL};
+	std::atomic<double> voice_integrated_lufs{-HUGE_VAL};
+	std::atomic<double> voice_lra{0.0};
+
+	// BGM metrics (sum of selected sources)
+	std::atomic<double> bgm_lufs{-HUGE_VAL};
+	std::atomic<double> bgm_peak_dbfs{-HUGE_VAL};
+	std::atomic<double> bgm_true_peak_dbtp{-HUGE_VAL};
+	std::atomic<double> bgm_integrated_lufs{-HUGE_VAL};
+	std::atomic<double> bgm_lra{0.0};
+
+	// Per-source BGM metrics, indexed by analyzer BGM input
+	BgmSourceResults bgm_sources[kMaxBgmSources];
+
+	// Mix metrics (Voice + BGM)
+	std::atomic<double> mix_lufs{-HUGE_VAL};
+	std::atomic<double> mix_peak_dbfs{-HUGE_VAL};
+	std::atomic<double> mix_true_peak_dbtp{-HUGE_VAL};
+	std::atomic<double> mix_integrated_lufs{-HUGE_VAL};
+	std::atomic<double> mix_lra{0.0};
+
+	// Output track metrics, indexed by track (0 = track 1); clip_status is judged per track
+	TrackResults tracks[kMaxOutputTracks];
+
+	// Voice-BGM delta (in LU)
+	std::atomic<double> balance_delta{0.0};
+
+	// Voice Activity
+	std::atomic<bool> voice_active{false};
+
+	// Judgments
+	std::atomic<Status> balance_status{Status::OK};
+	std::atomic<Status> mix_status{Status::OK};
+	std::atomic<Status> clip_status{Status::OK};
+
+	// Reset all values
+	void reset()
+	{
+		voice_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		voice_peak_dbfs.store(-HUGE_VAL, std::memory_order_relaxed);
+		voice_true_peak_dbtp.store(-HUGE_VAL, std::memory_order_relaxed);
+		voice_integrated_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		voice_lra.store(0.0, std::memory_order_relaxed);
+		bgm_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		bgm_peak_dbfs.store(-HUGE_VAL, std::memory_order_relaxed);
+		bgm_true_peak_dbtp.store(-HUGE_VAL, std::memory_order_relaxed);
+		bgm_integrated_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		bgm_lra.store(0.0, std::memory_order_relaxed);
+		for (BgmSourceResults &source : bgm_sources) {
+			source.reset();
+		}
+		mix_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		mix_peak_dbfs.store(-HUGE_VAL, std::memory_order_relaxed);
+		mix_true_peak_dbtp.store(-HUGE_VAL, std::memory_order_relaxed);
+		mix_integrated_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		mix_lra.store(0.0, std::memory_order_relaxed);
+		for (TrackResults &track : tracks) {
+			track.reset();
+		}
+		balance_delta.store(0.0, std::memory_order_relaxed);
+		voice_active.store(false, std::memory_order_relaxed);
+		balance_status.store(Status::OK, std::memory_order_relaxed);
+		mix_status.store(Status::OK, std::memory_order_relaxed);
+		clip_status.store(Status::OK, std::memory_order_relaxed);
+	}
+};
+
+// Configuration for thresholds (atomic for runtime adjustment)
+struct AnalysisConfig {
+	// VAD threshold in dBFS
+	std::atomic<double> vad_threshold{-40.0};
+
+	// Balance target (Voice - BGM delta, in LU)
+	std::atomic<double> balance_target{6.0};
+
+	// Balance thresholds: OK >= target, WARN >= target-3, BAD < target-3
+	// (target=6 means: OK>=6, WARN: 3-6, BAD<3)
+
+	// Mix loudness thresholds (LUFS)
+	std::atomic<double> mix_ok_threshold{-18.0};
+	std::atomic<double> mix_warn_threshold{-22.0};
+
+	// Hysteresis to prevent flickering (dB)
+	std::atomic<double> hysteresis{0.5};
+
+	// Clip detection thresholds, applied to the true peaks (dBTP)
+	static constexpr double kClipWarnThreshold = -1.0;
+	static constexpr double kClipBadThreshold = 0.0;
+};
+
+} // namespace lbm
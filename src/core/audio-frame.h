@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace lbm {
+
+// Level of a block, measured by the capture kernel while it writes the block
+struct BlockStats {
+	float peak{0.0f};        // Maximum absolute sample value of any channel (linear)
+	double sum_squares{0.0}; // Sum of squared samples over all channels (double accumulation)
+};
+
+// Energy of a voice block split where the VAD's 10 ms hops end, measured by the capture kernel
+// The producer knows where the stream stands, so it sets `hop` and `first` (frames up to the first hop end,
+// 1..hop); the kernel then fills one sum per piece: [0, first), whole hops, and whatever is left. The VAD adds
+// them up instead of reading the samples again.
+struct HopEnergy {
+	// Enough for a 4096-frame block at 44.1 kHz and above
+	static constexpr uint32_t kMaxPieces = 12;
+
+	uint32_t hop{0};
+	uint32_t first{0};
+	uint32_t pieces{0};      // 0: not split (too many pieces, or no hop layout given)
+	double sums[kMaxPieces]; // Sum of squares of each piece over all channels
+
+	// Pieces a block of `frames` frames splits into
+	uint32_t count(uint32_t frames) const
+	{
+		return (hop == 0 || first == 0) ? 0 : (frames <= first ? 1 : 2 + (frames - first - 1) / hop);
+	}
+
+	// Frame range of piece i; the piece ends a hop if its end is not cut short by the block
+	uint32_t start(uint32_t i) const { return i == 0 ? 0 : first + (i - 1) * hop; }
+	uint32_t end(uint32_t i, uint32_t frames) const { return std::min(first + i * hop, frames); }
+	bool ends_hop(uint32_t i, uint32_t frames) const { return first + i * hop <= frames; }
+
+	// Piece starting at frame `offset`
+	uint32_t piece_at(uint32_t offset) const { return offset == 0 ? 0 : 1 + (offset - first) / hop; }
+};
+
+// One planar block handed from an audio callback to the worker thread
+// The samples live in the SampleRing the frame was read from and stay valid until it is released.
+struct AudioFrame {
+	// Maximum samples per channel (enough for 4096 samples at any sample rate)
+	static constexpr size_t kMaxSamples = 4096;
+
+	// One plane per channel, back to back: channel c is samples[c * frame_count, (c + 1) * frame_count)
+	const float *samples{nullptr};
+
+	// Number of valid samples per channel
+	uint32_t frame_count{0};
+
+	// Number of planes (the analyzer's channel layout)
+	uint32_t channels{1};
+
+	// Timestamp from OBS in ns, source sync offset applied (0 = unknown)
+	uint64_t timestamp{0};
+
+	// Source id (for identifying BGM sources)
+	uint32_t source_id{0};
+
+	// Peak and energy of the samples, computed by the producer
+	BlockStats stats;
+
+	// Energy per VAD hop (voice queue only, else nullptr); lives in the ring like the samples
+	const HopEnergy *hops{nullptr};
+};
+
+} // namespace lbm
@@ -0,0 +1,377 @@
+#include "audio-kernels.h"
+
+#include "simd-target.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace lbm::kernels {
+
+namespace {
+
+// Capture kernels for one plane: write in[i] * volume to out, return the peak and add the sum of squares of each
+// piece to sums[p], piece p ending at ends[p] (the last end is the plane length). The whole plane is one pass: a
+// piece end inside a vector splits that vector's squares by lane, so the pieces cost no extra loads or stores.
+using CaptureKernel = float (*)(const float *in, float *out, float volume, const uint32_t *ends, uint32_t pieces,
+				double *sums);
+
+// Reference kernel; also finishes the samples of a piece the vector loop cannot split
+float capture_scalar(const float *in, float *out, float volume, const uint32_t *ends, uint32_t pieces,
+		     double *sums)
+{
+	float peak = 0.0f;
+	uint32_t i = 0;
+	for (uint32_t p = 0; p < pieces; ++p) {
+		double sum = 0.0;
+		for (; i < ends[p]; ++i) {
+			const float s = in[i] * volume;
+			out[i] = s;
+			peak = std::max(peak, std::fabs(s));
+			sum += static_cast<double>(s) * s;
+		}
+		sums[p] += sum;
+	}
+	return peak;
+}
+
+// The SIMD kernels load each input sample once and keep the peak in a float vector and the sum of squares in
+// double vectors (each float widened before squaring, as in sum_squares()). At a piece end the lanes before it
+// close the piece and the rest open the next one; a piece too short for that (shorter than a vector) and the
+// block's tail fall back to capture_scalar().
+
+#ifdef LBM_SIMD_SSE2
+float capture_sse2(const float *in, float *out, float volume, const uint32_t *ends, uint32_t pieces,
+		   double *sums)
+{
+	const __m128 gain = _mm_set1_ps(volume);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128d lanes_lo = _mm_set_pd(1.0, 0.0);
+	const __m128d lanes_hi = _mm_set_pd(3.0, 2.0);
+	__m128 peak = _mm_setzero_ps();
+	__m128d sum_lo = _mm_setzero_pd();
+	__m128d sum_hi = _mm_setzero_pd();
+	float tail_peak = 0.0f;
+
+	uint32_t i = 0;
+	for (uint32_t p = 0; p < pieces; ++p) {
+		const uint32_t end = ends[p];
+		__m128d sq_lo = _mm_setzero_pd();
+		__m128d sq_hi = _mm_setzero_pd();
+		for (; i + 4 <= end; i += 4) {
+			const __m128 s = _mm_mul_ps(_mm_loadu_ps(in + i), gain);
+			_mm_storeu_ps(out + i, s);
+
+			peak = _mm_max_ps(_mm_andnot_ps(sign, s), peak);
+			const __m128d lo = _mm_cvtps_pd(s);
+			const __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(s, s));
+			sum_lo = _mm_add_pd(sum_lo, _mm_mul_pd(lo, lo));
+			sum_hi = _mm_add_pd(sum_hi, _mm_mul_pd(hi, hi));
+		}
+
+		const bool split = i < end && p + 1 < pieces && i + 4 <= ends[p + 1];
+		if (split) {
+			const __m128 s = _mm_mul_ps(_mm_loadu_ps(in + i), gain);
+			_mm_storeu_ps(out + i, s);
+
+			peak = _mm_max_ps(_mm_andnot_ps(sign, s), peak);
+			const __m128d lo = _mm_cvtps_pd(s);
+			const __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(s, s));
+			sq_lo = _mm_mul_pd(lo, lo);
+			sq_hi = _mm_mul_pd(hi, hi);
+			const __m128d cut = _mm_set1_pd(static_cast<double>(end - i));
+			const __m128d keep_lo = _mm_cmplt_pd(lanes_lo, cut);
+			const __m128d keep_hi = _mm_cmplt_pd(lanes_hi, cut);
+			sum_lo = _mm_add_pd(sum_lo, _mm_and_pd(keep_lo, sq_lo));
+			sum_hi = _mm_add_pd(sum_hi, _mm_and_pd(keep_hi, sq_hi));
+			sq_lo = _mm_andnot_pd(keep_lo, sq_lo);
+			sq_hi = _mm_andnot_pd(keep_hi, sq_hi);
+			i += 4;
+		}
+
+		const __m128d sum = _mm_add_pd(sum_lo, sum_hi);
+		sums[p] += _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+		sum_lo = sq_lo;
+		sum_hi = sq_hi;
+		if (!split && i < end) {
+			const uint32_t rest = end - i;
+			tail_peak = std::max(tail_peak,
+					     capture_scalar(in + i, out + i, volume, &rest, 1, &sums[p]));
+			i = end;
+		}
+	}
+
+	peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+	peak = _mm_max_ss(peak, _mm_shuffle_ps(peak, peak, 1));
+	return std::max(tail_peak, _mm_cvtss_f32(peak));
+}
+#endif
+
+#ifdef LBM_SIMD_X86
+LBM_TARGET_AVX2 float capture_avx2(const float *in, float *out, float volume, const uint32_t *ends, uint32_t pieces,
+				   double *sums)
+{
+	const __m256 gain = _mm256_set1_ps(volume);
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	const __m256d lanes_lo = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+	const __m256d lanes_hi = _mm256_set_pd(7.0, 6.0, 5.0, 4.0);
+	__m256 peak = _mm256_setzero_ps();
+	__m256d sum_lo = _mm256_setzero_pd();
+	__m256d sum_hi = _mm256_setzero_pd();
+	float tail_peak = 0.0f;
+
+	uint32_t i = 0;
+	for (uint32_t p = 0; p < pieces; ++p) {
+		const uint32_t end = ends[p];
+		__m256d sq_lo = _mm256_setzero_pd();
+		__m256d sq_hi = _mm256_setzero_pd();
+		for (; i + 8 <= end; i += 8) {
+			const __m256 s = _mm256_mul_ps(_mm256_loadu_ps(in + i), gain);
+			_mm256_storeu_ps(out + i, s);
+
+			peak = _mm256_max_ps(_mm256_andnot_ps(sign, s), peak);
+			const __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(s));
+			const __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(s, 1));
+			sum_lo = _mm256_add_pd(sum_lo, _mm256_mul_pd(lo, lo));
+			sum_hi = _mm256_add_pd(sum_hi, _mm256_mul_pd(hi, hi));
+		}
+
+		const bool split = i < end && p + 1 < pieces && i + 8 <= ends[p + 1];
+		if (split) {
+			const __m256 s = _mm256_mul_ps(_mm256_loadu_ps(in + i), gain);
+			_mm256_storeu_ps(out + i, s);
+
+			peak = _mm256_max_ps(_mm256_andnot_ps(sign, s), peak);
+			const __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(s));
+			const __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(s, 1));
+			sq_lo = _mm256_mul_pd(lo, lo);
+			sq_hi = _mm256_mul_pd(hi, hi);
+			const __m256d cut = _mm256_set1_pd(static_cast<double>(end - i));
+			const __m256d keep_lo = _mm256_cmp_pd(lanes_lo, cut, _CMP_LT_OQ);
+			const __m256d keep_hi = _mm256_cmp_pd(lanes_hi, cut, _CMP_LT_OQ);
+			sum_lo = _mm256_add_pd(sum_lo, _mm256_and_pd(keep_lo, sq_lo));
+			sum_hi = _mm256_add_pd(sum_hi, _mm256_and_pd(keep_hi, sq_hi));
+			sq_lo = _mm256_andnot_pd(keep_lo, sq_lo);
+			sq_hi = _mm256_andnot_pd(keep_hi, sq_hi);
+			i += 8;
+		}
+
+		const __m256d sum4 = _mm256_add_pd(sum_lo, sum_hi);
+		const __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(sum4), _mm256_extractf128_pd(sum4, 1));
+		sums[p] += _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+		sum_lo = sq_lo;
+		sum_hi = sq_hi;
+		if (!split && i < end) {
+			const uint32_t rest = end - i;
+			tail_peak = std::max(tail_peak,
+					     capture_scalar(in + i, out + i, volume, &rest, 1, &sums[p]));
+			i = end;
+		}
+	}
+
+	__m128 peak4 = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+	peak4 = _mm_max_ps(peak4, _mm_movehl_ps(peak4, peak4));
+	peak4 = _mm_max_ss(peak4, _mm_shuffle_ps(peak4, peak4, 1));
+	return std::max(tail_peak, _mm_cvtss_f32(peak4));
+}
+#endif
+
+#ifdef LBM_SIMD_NEON
+float capture_neon(const float *in, float *out, float volume, const uint32_t *ends, uint32_t pieces,
+		   double *sums)
+{
+	static const double kLanes[4] = {0.0, 1.0, 2.0, 3.0};
+	const float64x2_t lanes_lo = vld1q_f64(kLanes);
+	const float64x2_t lanes_hi = vld1q_f64(kLanes + 2);
+	const float64x2_t zero = vdupq_n_f64(0.0);
+	float32x4_t peak = vdupq_n_f32(0.0f);
+	float64x2_t sum_lo = zero;
+	float64x2_t sum_hi = zero;
+	float tail_peak = 0.0f;
+
+	uint32_t i = 0;
+	for (uint32_t p = 0; p < pieces; ++p) {
+		const uint32_t end = ends[p];
+		float64x2_t sq_lo = zero;
+		float64x2_t sq_hi = zero;
+		for (; i + 4 <= end; i += 4) {
+			const float32x4_t s = vmulq_n_f32(vld1q_f32(in + i), volume);
+			vst1q_f32(out + i, s);
+
+			peak = vmaxq_f32(vabsq_f32(s), peak);
+			const float64x2_t lo = vcvt_f64_f32(vget_low_f32(s));
+			const float64x2_t hi = vcvt_high_f64_f32(s);
+			sum_lo = vaddq_f64(sum_lo, vmulq_f64(lo, lo));
+			sum_hi = vaddq_f64(sum_hi, vmulq_f64(hi, hi));
+		}
+
+		const bool split = i < end && p + 1 < pieces && i + 4 <= ends[p + 1];
+		if (split) {
+			const float32x4_t s = vmulq_n_f32(vld1q_f32(in + i), volume);
+			vst1q_f32(out + i, s);
+
+			peak = vmaxq_f32(vabsq_f32(s), peak);
+			const float64x2_t lo = vcvt_f64_f32(vget_low_f32(s));
+			const float64x2_t hi = vcvt_high_f64_f32(s);
+			sq_lo = vmulq_f64(lo, lo);
+			sq_hi = vmulq_f64(hi, hi);
+			const float64x2_t cut = vdupq_n_f64(static_cast<double>(end - i));
+			const uint64x2_t keep_lo = vcltq_f64(lanes_lo, cut);
+			const uint64x2_t keep_hi = vcltq_f64(lanes_hi, cut);
+			sum_lo = vaddq_f64(sum_lo, vbslq_f64(keep_lo, sq_lo, zero));
+			sum_hi = vaddq_f64(sum_hi, vbslq_f64(keep_hi, sq_hi, zero));
+			sq_lo = vbslq_f64(keep_lo, zero, sq_lo);
+			sq_hi = vbslq_f64(keep_hi, zero, sq_hi);
+			i += 4;
+		}
+
+		sums[p] += vaddvq_f64(vaddq_f64(sum_lo, sum_hi));
+		sum_lo = sq_lo;
+		sum_hi = sq_hi;
+		if (!split && i < end) {
+			const uint32_t rest = end - i;
+			tail_peak = std::max(tail_peak,
+					     capture_scalar(in + i, out + i, volume, &rest, 1, &sums[p]));
+			i = end;
+		}
+	}
+
+	return std::max(tail_peak, vmaxvq_f32(peak));
+}
+#endif
+
+CaptureKernel capture_kernel(SimdLevel level)
+{
+	if (!simd_level_supported(level)) {
+		level = detect_simd_level();
+	}
+
+	switch (level) {
+#ifdef LBM_SIMD_SSE2
+	case SimdLevel::SSE2:
+		return capture_sse2;
+#endif
+#ifdef LBM_SIMD_X86
+	case SimdLevel::AVX2:
+		return capture_avx2;
+#endif
+#ifdef LBM_SIMD_NEON
+	case SimdLevel::NEON:
+		return capture_neon;
+#endif
+	default:
+		return capture_scalar;
+	}
+}
+
+// Resolved on the first callback
+CaptureKernel detected_kernel()
+{
+	static const CaptureKernel kernel = capture_kernel(detect_simd_level());
+	return kernel;
+}
+
+// Capture every plane, adding each piece's energy over all channels to sums[p]
+float capture_pieces(CaptureKernel kernel, const float *const *planes, uint32_t channels, float *out,
+		     uint32_t frames, float volume, const uint32_t *ends, uint32_t pieces, double *sums)
+{
+	float peak = 0.0f;
+	for (uint32_t c = 0; c < channels; ++c) {
+		float *plane = out + static_cast<size_t>(c) * frames;
+		if (!planes[c]) {
+			std::memset(plane, 0, frames * sizeof(float));
+			continue;
+		}
+		peak = std::max(peak, kernel(planes[c], plane, volume, ends, pieces, sums));
+	}
+	return peak;
+}
+
+BlockStats capture_with(CaptureKernel kernel, const float *const *planes, uint32_t channels, float *out,
+			uint32_t frames, float volume)
+{
+	BlockStats stats;
+	stats.peak = capture_pieces(kernel, planes, channels, out, frames, volume, &frames, 1, &stats.sum_squares);
+	return stats;
+}
+
+// The voice capture: the same single pass per plane, its energy split at the hop ends
+BlockStats capture_hops_with(CaptureKernel kernel, const float *const *planes, uint32_t channels, float *out,
+			     uint32_t frames, float volume, HopEnergy &hops)
+{
+	const uint32_t pieces = hops.count(frames);
+	if (pieces == 0 || pieces > HopEnergy::kMaxPieces) {
+		hops.pieces = 0;
+		return capture_with(kernel, planes, channels, out, frames, volume);
+	}
+
+	uint32_t ends[HopEnergy::kMaxPieces];
+	for (uint32_t i = 0; i < pieces; ++i) {
+		ends[i] = hops.end(i, frames);
+		hops.sums[i] = 0.0;
+	}
+	hops.pieces = pieces;
+
+	BlockStats stats;
+	stats.peak = capture_pieces(kernel, planes, channels, out, frames, volume, ends, pieces, hops.sums);
+	for (uint32_t i = 0; i < pieces; ++i) {
+		stats.sum_squares += hops.sums[i];
+	}
+	return stats;
+}
+
+} // namespace
+
+BlockStats capture_planes(const float *const *planes, uint32_t channels, float *out, uint32_t frames, float volume)
+{
+	return capture_with(detected_kernel(), planes, channels, out, frames, volume);
+}
+
+BlockStats capture_planes(const float *const *planes, uint32_t channels, float *out, uint32_t frames, float volume,
+			  HopEnergy &hops)
+{
+	return capture_hops_with(detected_kernel(), planes, channels, out, frames, volume, hops);
+}
+
+BlockStats capture_planes(SimdLevel level, const float *const *planes, uint32_t channels, float *out,
+			  uint32_t frames, float volume)
+{
+	return capture_with(capture_kernel(level), planes, channels, out, frames, volume);
+}
+
+BlockStats capture_planes(SimdLevel level, const float *const *planes, uint32_t channels, float *out,
+			  uint32_t frames, float volume, HopEnergy &hops)
+{
+	return capture_hops_with(capture_kernel(level), planes, channels, out, frames, volume, hops);
+}
+
+void accumulate(float *dst, const float *src, uint32_t frames)
+{
+	// Plain loop so the compiler can vectorize it
+	for (uint32_t i = 0; i < frames; ++i) {
+		dst[i] += src[i];
+	}
+}
+
+double peak_abs(const float *samples, uint32_t frames)
+{
+	double peak = 0.0;
+	for (uint32_t i = 0; i < frames; ++i) {
+		double abs_val = std::fabs(samples[i]);
+		if (abs_val > peak)
+			peak = abs_val;
+	}
+	return peak;
+}
+
+double sum_squares(const float *samples, uint32_t frames)
+{
+	double sum_sq = 0.0;
+	for (uint32_t i = 0; i < frames; ++i) {
+		double s = static_cast<double>(samples[i]);
+		sum_sq += s * s;
+	}
+	return sum_sq;
+}
+
+} // namespace lbm::kernels
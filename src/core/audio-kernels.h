@@ -0,0 +1,39 @@
+#pragma once
+
+#include "audio-frame.h"
+#include "k-weighting.h"
+
+#include <cstdint>
+
+namespace lbm::kernels {
+
+// Hot-path sample kernels shared by the capture callbacks, the analyzer and the VAD
+// Kept free of OBS types so they can be benchmarked headless
+
+// Capture pass: copy `channels` planes into `out` (plane c at out + c * frames) with the volume fader applied,
+// measuring the peak and sum of squares of the whole block in the same pass. Null planes are written as silence.
+// The samples are bit-identical on every SIMD level; sum_squares differs only by summation order.
+BlockStats capture_planes(const float *const *planes, uint32_t channels, float *out, uint32_t frames, float volume);
+
+// Same with a forced kernel (clamped to what the CPU supports), for benchmarks and validation
+BlockStats capture_planes(SimdLevel level, const float *const *planes, uint32_t channels, float *out,
+			  uint32_t frames, float volume);
+
+// Same, also splitting the sum of squares at the hop ends `hops` describes (hop and first set by the caller), in
+// the same single pass over each plane; fills hops.pieces and hops.sums, or leaves pieces at 0 if the block needs
+// more than HopEnergy::kMaxPieces
+BlockStats capture_planes(const float *const *planes, uint32_t channels, float *out, uint32_t frames, float volume,
+			  HopEnergy &hops);
+BlockStats capture_planes(SimdLevel level, const float *const *planes, uint32_t channels, float *out,
+			  uint32_t frames, float volume, HopEnergy &hops);
+
+// Mix src into dst (dst[i] += src[i])
+void accumulate(float *dst, const float *src, uint32_t frames);
+
+// Maximum absolute sample value (linear)
+double peak_abs(const float *samples, uint32_t frames);
+
+// Sum of squared samples (double accumulation)
+double sum_squares(const float *samples, uint32_t frames);
+
+} // namespace lbm::kernels
@@ -0,0 +1,265 @@
+#include "callback-recording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace lbm {
+
+// === CallbackRecorder ===
+
+CallbackRecorder::CallbackRecorder(size_t ring_bytes)
+{
+	// Round up to a power of two
+	size_t capacity = 1;
+	while (capacity < ring_bytes) {
+		capacity <<= 1;
+	}
+	ring_ = std::make_unique<uint8_t[]>(capacity);
+	ring_mask_ = capacity - 1;
+}
+
+CallbackRecorder::~CallbackRecorder()
+{
+	stop();
+}
+
+bool CallbackRecorder::start(const std::string &path, uint32_t sample_rate)
+{
+	if (active_.load(std::memory_order_relaxed) || writer_running_.load(std::memory_order_relaxed)) {
+		return false;
+	}
+
+	file_ = std::fopen(path.c_str(), "wb");
+	if (!file_) {
+		return false;
+	}
+
+	RecordingFileHeader header{};
+	std::memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+	header.version = kRecordingVersion;
+	header.sample_rate = sample_rate;
+	if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+		std::fclose(file_);
+		file_ = nullptr;
+		return false;
+	}
+
+	write_pos_.store(0, std::memory_order_relaxed);
+	read_pos_.store(0, std::memory_order_relaxed);
+	source_count_ = 0;
+	recorded_.store(0, std::memory_order_relaxed);
+	dropped_.store(0, std::memory_order_relaxed);
+
+	writer_running_.store(true, std::memory_order_release);
+	writer_thread_ = std::thread(&CallbackRecorder::writer_loop, this);
+	active_.store(true);
+	return true;
+}
+
+void CallbackRecorder::stop()
+{
+	if (!writer_running_.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	// Stop accepting records and wait for any callback still writing into the ring
+	active_.store(false);
+	while (producers_in_flight_.load() != 0) {
+		std::this_thread::yield();
+	}
+
+	writer_running_.store(false, std::memory_order_release);
+	if (writer_thread_.joinable()) {
+		writer_thread_.join();
+	}
+
+	std::fclose(file_);
+	file_ = nullptr;
+}
+
+uint32_t CallbackRecorder::source_id(const void *key)
+{
+	for (uint32_t i = 0; i < source_count_; ++i) {
+		if (source_keys_[i] == key) {
+			return i;
+		}
+	}
+	if (source_count_ < kMaxSources) {
+		source_keys_[source_count_] = key;
+		return source_count_++;
+	}
+	return kMaxSources; // Table full: shared overflow id
+}
+
+void CallbackRecorder::ring_write(uint64_t pos, const void *src, size_t bytes)
+{
+	const size_t offset = static_cast<size_t>(pos) & ring_mask_;
+	const size_t first = std::min(bytes, ring_mask_ + 1 - offset);
+	std::memcpy(ring_.get() + offset, src, first);
+	if (first < bytes) {
+		std::memcpy(ring_.get(), static_cast<const uint8_t *>(src) + first, bytes - first);
+	}
+}
+
+void CallbackRecorder::record(RecordedStream stream, const void *source_key, const float *const *planes,
+			      uint32_t channels, uint32_t frames, uint64_t timestamp, int64_t sync_offset, float volume,
+			      bool muted)
+{
+	producers_in_flight_.fetch_add(1);
+	if (!active_.load()) {
+		producers_in_flight_.fetch_sub(1);
+		return;
+	}
+
+	channels = std::min(channels, kMaxRecordedChannels);
+	const size_t plane_bytes = static_cast<size_t>(frames) * sizeof(float);
+	const size_t total = sizeof(RecordingRecordHeader) + plane_bytes * channels;
+
+	const uint64_t write_pos = write_pos_.load(std::memory_order_relaxed);
+	const uint64_t read_pos = read_pos_.load(std::memory_order_acquire);
+	if (write_pos + total - read_pos > ring_mask_ + 1) {
+		// Writer thread is behind; never block the audio thread
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		producers_in_flight_.fetch_sub(1);
+		return;
+	}
+
+	RecordingRecordHeader header{};
+	header.timestamp = timestamp;
+	header.frames = frames;
+	header.source_id = source_id(source_key);
+	header.volume = volume;
+	header.stream = static_cast<uint8_t>(stream);
+	header.channels = static_cast<uint8_t>(channels);
+	header.flags = muted ? kRecordFlagMuted : 0;
+	header.sync_offset = sync_offset;
+
+	uint64_t pos = write_pos;
+	ring_write(pos, &header, sizeof(header));
+	pos += sizeof(header);
+	for (uint32_t ch = 0; ch < channels; ++ch) {
+		ring_write(pos, planes[ch], plane_bytes);
+		pos += plane_bytes;
+	}
+
+	write_pos_.store(pos, std::memory_order_release);
+	recorded_.fetch_add(1, std::memory_order_relaxed);
+	producers_in_flight_.fetch_sub(1);
+}
+
+size_t CallbackRecorder::drain()
+{
+	const uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+	const uint64_t write_pos = write_pos_.load(std::memory_order_acquire);
+	const size_t bytes = static_cast<size_t>(write_pos - read_pos);
+	if (bytes == 0) {
+		return 0;
+	}
+
+	const size_t offset = static_cast<size_t>(read_pos) & ring_mask_;
+	const size_t first = std::min(bytes, ring_mask_ + 1 - offset);
+	std::fwrite(ring_.get() + offset, 1, first, file_);
+	if (first < bytes) {
+		std::fwrite(ring_.get(), 1, bytes - first, file_);
+	}
+
+	read_pos_.store(write_pos, std::memory_order_release);
+	return bytes;
+}
+
+void CallbackRecorder::writer_loop()
+{
+	while (writer_running_.load(std::memory_order_acquire)) {
+		if (drain() == 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	// Final flush after producers have stopped
+	drain();
+	std::fflush(file_);
+}
+
+// === CallbackRecordingReader ===
+
+CallbackRecordingReader::~CallbackRecordingReader()
+{
+	close();
+}
+
+bool CallbackRecordingReader::open(const std::string &path)
+{
+	close();
+	error_.clear();
+
+	file_ = std::fopen(path.c_str(), "rb");
+	if (!file_) {
+		error_ = "cannot open " + path;
+		return false;
+	}
+
+	RecordingFileHeader header{};
+	if (std::fread(&header, sizeof(header), 1, file_) != 1 ||
+	    std::memcmp(header.magic, kRecordingMagic, sizeof(header.magic)) != 0) {
+		error_ = path + ": not a capture recording";
+		close();
+		return false;
+	}
+	if (header.version != 1 && header.version != kRecordingVersion) {
+		error_ = path + ": unsupported recording version";
+		close();
+		return false;
+	}
+
+	sample_rate_ = header.sample_rate;
+	header_size_ = (header.version == 1) ? kRecordHeaderSizeV1 : sizeof(RecordingRecordHeader);
+	return true;
+}
+
+void CallbackRecordingReader::close()
+{
+	if (file_) {
+		std::fclose(file_);
+		file_ = nullptr;
+	}
+}
+
+bool CallbackRecordingReader::next(RecordedCallback &record)
+{
+	if (!file_) {
+		return false;
+	}
+
+	RecordingRecordHeader header{};
+	size_t got = std::fread(&header, 1, header_size_, file_);
+	if (got == 0) {
+		return false; // Clean end of file
+	}
+	if (got != header_size_ || header.channels > kMaxRecordedChannels) {
+		error_ = "truncated or corrupt record";
+		return false;
+	}
+
+	const size_t samples = static_cast<size_t>(header.frames) * header.channels;
+	samples_.resize(samples);
+	if (samples > 0 && std::fread(samples_.data(), sizeof(float), samples, file_) != samples) {
+		error_ = "truncated record data";
+		return false;
+	}
+
+	record.stream = static_cast<RecordedStream>(header.stream);
+	record.source_id = header.source_id;
+	record.channels = header.channels;
+	record.frames = header.frames;
+	record.timestamp = header.timestamp;
+	record.sync_offset = header.sync_offset;
+	record.volume = header.volume;
+	record.muted = (header.flags & kRecordFlagMuted) != 0;
+	for (uint32_t ch = 0; ch < kMaxRecordedChannels; ++ch) {
+		record.planes[ch] = (ch < header.channels) ? samples_.data() + ch * header.frames : nullptr;
+	}
+	return true;
+}
+
+} // namespace lbm
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lbm {
+
+// Binary recording of capture callbacks (little-endian)
+//
+//   RecordingFileHeader
+//   { RecordingRecordHeader, float planes[channels][frames] } ...
+//
+// Version 1 records end before RecordingRecordHeader::sync_offset (kRecordHeaderSizeV1 bytes).
+//
+// Every callback is stored as delivered by OBS (planar, before downmix/fader, including muted ones)
+// so that replay can reproduce the analyzer input exactly.
+
+struct RecordingFileHeader {
+	char magic[8];          // "LBMREC01"
+	uint32_t version;       // kRecordingVersion
+	uint32_t sample_rate;   // OBS output sample rate at recording start
+};
+
+struct RecordingRecordHeader {
+	uint64_t timestamp; // audio_data::timestamp (ns)
+	uint32_t frames;
+	uint32_t source_id; // stable per-recording id (order of first appearance)
+	float volume;       // obs_source_get_volume at callback time
+	uint8_t stream;     // RecordedStream
+	uint8_t channels;   // number of planes stored
+	uint8_t flags;      // kRecordFlagMuted
+	uint8_t reserved;
+	int64_t sync_offset; // obs_source_get_sync_offset at callback time (ns), version 2+
+};
+
+static_assert(sizeof(RecordingFileHeader) == 16, "unexpected RecordingFileHeader size");
+static_assert(sizeof(RecordingRecordHeader) == 32, "unexpected RecordingRecordHeader size");
+
+constexpr char kRecordingMagic[8] = {'L', 'B', 'M', 'R', 'E', 'C', '0', '1'};
+constexpr uint32_t kRecordingVersion = 2;
+constexpr size_t kRecordHeaderSizeV1 = 24;
+constexpr uint8_t kRecordFlagMuted = 0x01;
+constexpr uint32_t kMaxRecordedChannels = 8; // MAX_AV_PLANES
+
+enum class RecordedStream : uint8_t { Voice = 0, BGM = 1 };
+
+// One decoded callback record
+struct RecordedCallback {
+	RecordedStream stream{RecordedStream::Voice};
+	uint32_t source_id{0};
+	uint32_t channels{0};
+	uint32_t frames{0};
+	uint64_t timestamp{0};
+	int64_t sync_offset{0};
+	float volume{1.0f};
+	bool muted{false};
+
+	// Planar samples (valid until the next CallbackRecordingReader::next call)
+	const float *planes[kMaxRecordedChannels]{};
+};
+
+// Records capture callbacks to a file without blocking the audio thread
+// record() copies into a lock-free byte ring; a writer thread drains it to disk.
+// record() must be called from a single producer thread (the OBS audio thread).
+class CallbackRecorder {
+public:
+	explicit CallbackRecorder(size_t ring_bytes = kDefaultRingBytes);
+	~CallbackRecorder();
+
+	// Non-copyable
+	CallbackRecorder(const CallbackRecorder &) = delete;
+	CallbackRecorder &operator=(const CallbackRecorder &) = delete;
+
+	// Open the output file and start the writer thread
+	bool start(const std::string &path, uint32_t sample_rate);
+
+	// Stop recording, flush everything already recorded and close the file
+	void stop();
+
+	bool is_active() const { return active_.load(std::memory_order_relaxed); }
+
+	// Audio thread: append one callback (dropped if the ring is full)
+	void record(RecordedStream stream, const void *source_key, const float *const *planes, uint32_t channels,
+		    uint32_t frames, uint64_t timestamp, int64_t sync_offset, float volume, bool muted);
+
+	uint64_t recorded_count() const { return recorded_.load(std::memory_order_relaxed); }
+	uint64_t dropped_count() const { return dropped_.load(std::memory_order_relaxed); }
+
+	// ~5 s of 8-channel 48 kHz audio
+	static constexpr size_t kDefaultRingBytes = 8 * 1024 * 1024;
+
+private:
+	void writer_loop();
+	size_t drain();
+	uint32_t source_id(const void *key);
+	void ring_write(uint64_t pos, const void *src, size_t bytes);
+
+	// Byte ring (power-of-two capacity, monotonically increasing positions)
+	std::unique_ptr<uint8_t[]> ring_;
+	size_t ring_mask_{0};
+	std::atomic<uint64_t> write_pos_{0}; // Producer writes here
+	std::atomic<uint64_t> read_pos_{0};  // Writer thread reads here
+
+	// Producer-side source id table (first-appearance order)
+	static constexpr uint32_t kMaxSources = 64;
+	const void *source_keys_[kMaxSources]{};
+	uint32_t source_count_{0};
+
+	std::atomic<bool> active_{false};
+	std::atomic<int> producers_in_flight_{0};
+	std::atomic<bool> writer_running_{false};
+	std::thread writer_thread_;
+	FILE *file_{nullptr};
+
+	std::atomic<uint64_t> recorded_{0};
+	std::atomic<uint64_t> dropped_{0};
+};
+
+// Streaming reader for CallbackRecorder files (constant memory)
+class CallbackRecordingReader {
+public:
+	CallbackRecordingReader() = default;
+	~CallbackRecordingReader();
+
+	// Non-copyable
+	CallbackRecordingReader(const CallbackRecordingReader &) = delete;
+	CallbackRecordingReader &operator=(const CallbackRecordingReader &) = delete;
+
+	bool open(const std::string &path);
+	void close();
+
+	uint32_t sample_rate() const { return sample_rate_; }
+
+	// Read the next record; returns false at end of file or on error (see error())
+	bool next(RecordedCallback &record);
+
+	const std::string &error() const { return error_; }
+
+private:
+	FILE *file_{nullptr};
+	uint32_t sample_rate_{0};
+	size_t header_size_{sizeof(RecordingRecordHeader)};
+	std::vector<float> samples_;
+	std::string error_;
+};
+
+} // namespace lbm
@@ -0,0 +1,69 @@
+#include "channel-layout.h"
+
+namespace lbm {
+
+namespace {
+
+constexpr uint32_t kLfeChannel = 3; // 4.1, 5.1 and 7.1 (2.1 has it at 2)
+
+} // namespace
+
+bool layout_for_channels(uint32_t channels, ChannelLayout &layout)
+{
+	switch (channels) {
+	case 1:
+	case 2:
+	case 3:
+	case 4:
+	case 5:
+	case 6:
+	case 8:
+		layout = static_cast<ChannelLayout>(channels);
+		return true;
+	default:
+		return false;
+	}
+}
+
+const char *channel_layout_name(ChannelLayout layout)
+{
+	switch (layout) {
+	case ChannelLayout::Mono:
+		return "mono";
+	case ChannelLayout::Stereo:
+		return "stereo";
+	case ChannelLayout::Surround2_1:
+		return "2.1";
+	case ChannelLayout::Surround4_0:
+		return "4.0";
+	case ChannelLayout::Surround4_1:
+		return "4.1";
+	case ChannelLayout::Surround5_1:
+		return "5.1";
+	case ChannelLayout::Surround7_1:
+		return "7.1";
+	}
+	return "unknown";
+}
+
+double channel_weight(ChannelLayout layout, uint32_t channel)
+{
+	if (channel >= channel_count(layout)) {
+		return 0.0;
+	}
+
+	switch (layout) {
+	case ChannelLayout::Surround2_1:
+		return channel == 2 ? 0.0 : 1.0;
+	case ChannelLayout::Surround4_1:
+		return channel == kLfeChannel ? 0.0 : 1.0;
+	case ChannelLayout::Surround5_1:
+		return channel == kLfeChannel ? 0.0 : (channel >= 4 ? 1.41 : 1.0);
+	case ChannelLayout::Surround7_1:
+		return channel == kLfeChannel ? 0.0 : (channel >= 6 ? 1.41 : 1.0);
+	default:
+		return 1.0;
+	}
+}
+
+} // namespace lbm
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lbm {
+
+// Speaker layout the analyzer measures in (values match OBS's enum speaker_layout, which equal the channel count)
+//
+// Channel order follows OBS:
+//   Mono        C
+//   Stereo      L R
+//   Surround2_1 L R LFE
+//   Surround4_0 L R C Cs
+//   Surround4_1 L R C LFE Cs
+//   Surround5_1 L R C LFE Ls Rs
+//   Surround7_1 L R C LFE Lb Rb Ls Rs
+enum class ChannelLayout : uint8_t {
+	Mono = 1,
+	Stereo = 2,
+	Surround2_1 = 3,
+	Surround4_0 = 4,
+	Surround4_1 = 5,
+	Surround5_1 = 6,
+	Surround7_1 = 8,
+};
+
+// Most channels any layout has
+constexpr uint32_t kMaxChannels = 8;
+
+inline uint32_t channel_count(ChannelLayout layout)
+{
+	return static_cast<uint32_t>(layout);
+}
+
+// Layout with `channels` channels; false if OBS has none
+bool layout_for_channels(uint32_t channels, ChannelLayout &layout);
+
+const char *channel_layout_name(ChannelLayout layout);
+
+// BS.1770-4 channel weighting G: 0 for the LFE (not measured), 1.41 (+1.5 dB) for the surrounds between 60 and
+// 120 degrees off centre (5.1 Ls/Rs, 7.1 side Ls/Rs), 1.0 for every other channel including rear centre and
+// 7.1 back channels
+double channel_weight(ChannelLayout layout, uint32_t channel);
+
+} // namespace lbm
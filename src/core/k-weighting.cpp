@@ -0,0 +1,752 @@
+#include "k-weighting.h"
+
+#include "loudness-meter.h"
+#include "simd-target.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace lbm {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr size_t kStride = KWeightingBank::kMaxLanes;
+constexpr size_t kLaneStride = KWeightingBank::kLaneStride;
+
+// Samples every non-idle lane of [first, first + width) has, and the most any of them has
+// (the bank restores idle lanes, so they need no masking)
+void group_extent(const size_t *frames, size_t first, size_t width, size_t &common, size_t &longest)
+{
+	common = SIZE_MAX;
+	longest = 0;
+	for (size_t l = first; l < first + width; ++l) {
+		if (frames[l] > 0) {
+			common = std::min(common, frames[l]);
+			longest = std::max(longest, frames[l]);
+		}
+	}
+	common = std::min(common, longest);
+}
+
+// Reference kernel: one lane at a time, same filter arithmetic as LoudnessMeter::add_frames
+void filter_scalar(const KWeighting &k, double (*z)[kStride], float *stage, const size_t *frames,
+		   const size_t *split, double (*energy)[kStride], size_t lanes, bool write_back)
+{
+	const Biquad s = k.shelf;
+	const Biquad h = k.highpass;
+
+	for (size_t l = 0; l < lanes; ++l) {
+		double z0 = z[0][l], z1 = z[1][l], z2 = z[2][l], z3 = z[3][l];
+		double sums[2] = {0.0, 0.0};
+		for (size_t t = 0; t < frames[l]; ++t) {
+			float &io = stage[l * kLaneStride + t];
+			const double x = io;
+			const double y = s.b0 * x + z0;
+			z0 = s.b1 * x - s.a1 * y + z1;
+			z1 = s.b2 * x - s.a2 * y;
+
+			const double w = h.b0 * y + z2;
+			z2 = h.b1 * y - h.a1 * w + z3;
+			z3 = h.b2 * y - h.a2 * w;
+
+			sums[t < split[l] ? 0 : 1] += w * w;
+			if (write_back) {
+				io = static_cast<float>(w);
+			}
+		}
+		z[0][l] = z0;
+		z[1][l] = z1;
+		z[2][l] = z2;
+		z[3][l] = z3;
+		energy[0][l] = sums[0];
+		energy[1][l] = sums[1];
+	}
+}
+
+// The SIMD kernels below share one shape. The recurrence is latency-bound, so a pass steps several vectors
+// of lanes together (unrolled at compile time so their state stays in registers) to overlap the dependency
+// chains. Lanes past their own frame count keep their state; the energy sums are masked the same way. With
+// write_back the filtered sample replaces its input in the stage (rows past a lane's frame count get junk).
+// No FMA is used, so every kernel matches filter_scalar bit for bit.
+
+#ifdef LBM_SIMD_SSE2
+struct Sse2Filter {
+	__m128d sb0, sb1, sb2, sa1, sa2, hb0, hb1, hb2, ha1, ha2;
+};
+
+// Two lanes
+struct Sse2Lanes {
+	__m128d z0, z1, z2, z3, frames, split, head, tail;
+};
+
+inline __m128d sse2_select(__m128d mask, __m128d a, __m128d b)
+{
+	return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+inline void sse2_load(Sse2Lanes &s, double (*z)[kStride], const size_t *frames, const size_t *split, size_t g)
+{
+	s.z0 = _mm_load_pd(&z[0][g]);
+	s.z1 = _mm_load_pd(&z[1][g]);
+	s.z2 = _mm_load_pd(&z[2][g]);
+	s.z3 = _mm_load_pd(&z[3][g]);
+	s.frames = _mm_set_pd(static_cast<double>(frames[g + 1]), static_cast<double>(frames[g]));
+	s.split = _mm_set_pd(static_cast<double>(split[g + 1]), static_cast<double>(split[g]));
+	s.head = _mm_setzero_pd();
+	s.tail = _mm_setzero_pd();
+}
+
+inline void sse2_step(const Sse2Filter &f, Sse2Lanes &s, float *in, __m128d now, bool live, bool write_back)
+{
+	const __m128d x = _mm_set_pd(in[kLaneStride], in[0]);
+
+	const __m128d y = _mm_add_pd(_mm_mul_pd(f.sb0, x), s.z0);
+	const __m128d n0 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(f.sb1, x), _mm_mul_pd(f.sa1, y)), s.z1);
+	const __m128d n1 = _mm_sub_pd(_mm_mul_pd(f.sb2, x), _mm_mul_pd(f.sa2, y));
+
+	const __m128d w = _mm_add_pd(_mm_mul_pd(f.hb0, y), s.z2);
+	const __m128d n2 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(f.hb1, y), _mm_mul_pd(f.ha1, w)), s.z3);
+	const __m128d n3 = _mm_sub_pd(_mm_mul_pd(f.hb2, y), _mm_mul_pd(f.ha2, w));
+
+	if (write_back) {
+		in[0] = static_cast<float>(_mm_cvtsd_f64(w));
+		in[kLaneStride] = static_cast<float>(_mm_cvtsd_f64(_mm_unpackhi_pd(w, w)));
+	}
+
+	const __m128d ww = _mm_mul_pd(w, w);
+	const __m128d in_head = _mm_cmplt_pd(now, s.split);
+	const __m128d valid = _mm_cmplt_pd(now, s.frames);
+	s.head = _mm_add_pd(s.head, _mm_and_pd(in_head, ww));
+	s.tail = _mm_add_pd(s.tail, _mm_and_pd(_mm_andnot_pd(in_head, valid), ww));
+
+	if (live) {
+		s.z0 = n0;
+		s.z1 = n1;
+		s.z2 = n2;
+		s.z3 = n3;
+	} else {
+		s.z0 = sse2_select(valid, n0, s.z0);
+		s.z1 = sse2_select(valid, n1, s.z1);
+		s.z2 = sse2_select(valid, n2, s.z2);
+		s.z3 = sse2_select(valid, n3, s.z3);
+	}
+}
+
+inline void sse2_store(const Sse2Lanes &s, double (*z)[kStride], double (*energy)[kStride], size_t g)
+{
+	_mm_store_pd(&z[0][g], s.z0);
+	_mm_store_pd(&z[1][g], s.z1);
+	_mm_store_pd(&z[2][g], s.z2);
+	_mm_store_pd(&z[3][g], s.z3);
+	_mm_store_pd(&energy[0][g], s.head);
+	_mm_store_pd(&energy[1][g], s.tail);
+}
+
+template<size_t... V>
+void sse2_pass(const KWeighting &k, double (*z)[kStride], float *stage, const size_t *frames,
+	       const size_t *split, double (*energy)[kStride], size_t first, bool write_back,
+	       std::index_sequence<V...>)
+{
+	const Sse2Filter f{_mm_set1_pd(k.shelf.b0),    _mm_set1_pd(k.shelf.b1),    _mm_set1_pd(k.shelf.b2),
+			   _mm_set1_pd(k.shelf.a1),    _mm_set1_pd(k.shelf.a2),    _mm_set1_pd(k.highpass.b0),
+			   _mm_set1_pd(k.highpass.b1), _mm_set1_pd(k.highpass.b2), _mm_set1_pd(k.highpass.a1),
+			   _mm_set1_pd(k.highpass.a2)};
+
+	size_t common, longest;
+	group_extent(frames, first, 2 * sizeof...(V), common, longest);
+
+	Sse2Lanes s[sizeof...(V)];
+	(sse2_load(s[V], z, frames, split, first + 2 * V), ...);
+	for (size_t t = 0; t < longest; ++t) {
+		float *in = stage + first * kLaneStride + t;
+		const __m128d now = _mm_set1_pd(static_cast<double>(t));
+		(sse2_step(f, s[V], in + 2 * V * kLaneStride, now, t < common, write_back), ...);
+	}
+	(sse2_store(s[V], z, energy, first + 2 * V), ...);
+}
+
+void filter_sse2(const KWeighting &k, double (*z)[kStride], float *stage, const size_t *frames,
+		 const size_t *split, double (*energy)[kStride], size_t lanes, bool write_back)
+{
+	size_t g = 0;
+	for (; g + 8 <= lanes; g += 8) {
+		sse2_pass(k, z, stage, frames, split, energy, g, write_back, std::make_index_sequence<4>());
+	}
+	if (g < lanes) {
+		sse2_pass(k, z, stage, frames, split, energy, g, write_back, std::make_index_sequence<2>());
+	}
+}
+#endif
+
+#ifdef LBM_SIMD_X86
+struct Avx2Filter {
+	__m256d sb0, sb1, sb2, sa1, sa2, hb0, hb1, hb2, ha1, ha2;
+};
+
+// Four lanes
+struct Avx2Lanes {
+	__m256d z0, z1, z2, z3, frames, split, head, tail;
+};
+
+LBM_TARGET_AVX2 inline void avx2_load(Avx2Lanes &s, double (*z)[kStride], const size_t *frames, const size_t *split,
+				      size_t g)
+{
+	s.z0 = _mm256_load_pd(&z[0][g]);
+	s.z1 = _mm256_load_pd(&z[1][g]);
+	s.z2 = _mm256_load_pd(&z[2][g]);
+	s.z3 = _mm256_load_pd(&z[3][g]);
+	s.frames = _mm256_set_pd(static_cast<double>(frames[g + 3]), static_cast<double>(frames[g + 2]),
+				 static_cast<double>(frames[g + 1]), static_cast<double>(frames[g]));
+	s.split = _mm256_set_pd(static_cast<double>(split[g + 3]), static_cast<double>(split[g + 2]),
+				static_cast<double>(split[g + 1]), static_cast<double>(split[g]));
+	s.head = _mm256_setzero_pd();
+	s.tail = _mm256_setzero_pd();
+}
+
+LBM_TARGET_AVX2 inline void avx2_step(const Avx2Filter &f, Avx2Lanes &s, float *in, __m256d now, bool live,
+				      bool write_back)
+{
+	const __m256d x = _mm256_cvtps_pd(
+		_mm_set_ps(in[3 * kLaneStride], in[2 * kLaneStride], in[kLaneStride], in[0]));
+
+	const __m256d y = _mm256_add_pd(_mm256_mul_pd(f.sb0, x), s.z0);
+	const __m256d n0 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(f.sb1, x), _mm256_mul_pd(f.sa1, y)), s.z1);
+	const __m256d n1 = _mm256_sub_pd(_mm256_mul_pd(f.sb2, x), _mm256_mul_pd(f.sa2, y));
+
+	const __m256d w = _mm256_add_pd(_mm256_mul_pd(f.hb0, y), s.z2);
+	const __m256d n2 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(f.hb1, y), _mm256_mul_pd(f.ha1, w)), s.z3);
+	const __m256d n3 = _mm256_sub_pd(_mm256_mul_pd(f.hb2, y), _mm256_mul_pd(f.ha2, w));
+
+	if (write_back) {
+		const __m128 out = _mm256_cvtpd_ps(w);
+		in[0] = _mm_cvtss_f32(out);
+		in[kLaneStride] = _mm_cvtss_f32(_mm_shuffle_ps(out, out, 1));
+		in[2 * kLaneStride] = _mm_cvtss_f32(_mm_shuffle_ps(out, out, 2));
+		in[3 * kLaneStride] = _mm_cvtss_f32(_mm_shuffle_ps(out, out, 3));
+	}
+
+	const __m256d ww = _mm256_mul_pd(w, w);
+	const __m256d in_head = _mm256_cmp_pd(now, s.split, _CMP_LT_OQ);
+	const __m256d valid = _mm256_cmp_pd(now, s.frames, _CMP_LT_OQ);
+	s.head = _mm256_add_pd(s.head, _mm256_and_pd(in_head, ww));
+	s.tail = _mm256_add_pd(s.tail, _mm256_and_pd(_mm256_andnot_pd(in_head, valid), ww));
+
+	if (live) {
+		s.z0 = n0;
+		s.z1 = n1;
+		s.z2 = n2;
+		s.z3 = n3;
+	} else {
+		s.z0 = _mm256_blendv_pd(s.z0, n0, valid);
+		s.z1 = _mm256_blendv_pd(s.z1, n1, valid);
+		s.z2 = _mm256_blendv_pd(s.z2, n2, valid);
+		s.z3 = _mm256_blendv_pd(s.z3, n3, valid);
+	}
+}
+
+LBM_TARGET_AVX2 inline void avx2_store(const Avx2Lanes &s, double (*z)[kStride], double (*energy)[kStride], size_t g)
+{
+	_mm256_store_pd(&z[0][g], s.z0);
+	_mm256_store_pd(&z[1][g], s.z1);
+	_mm256_store_pd(&z[2][g], s.z2);
+	_mm256_store_pd(&z[3][g], s.z3);
+	_mm256_store_pd(&energy[0][g], s.head);
+	_mm256_store_pd(&energy[1][g], s.tail);
+}
+
+template<size_t... V>
+LBM_TARGET_AVX2 void avx2_pass(const KWeighting &k, double (*z)[kStride], float *stage, const size_t *frames,
+			       const size_t *split, double (*energy)[kStride], size_t first, bool write_back,
+			       std::index_sequence<V...>)
+{
+	const Avx2Filter f{_mm256_set1_pd(k.shelf.b0),    _mm256_set1_pd(k.shelf.b1),
+			   _mm256_set1_pd(k.shelf.b2),    _mm256_set1_pd(k.shelf.a1),
+			   _mm256_set1_pd(k.shelf.a2),    _mm256_set1_pd(k.highpass.b0),
+			   _mm256_set1_pd(k.highpass.b1), _mm256_set1_pd(k.highpass.b2),
+			   _mm256_set1_pd(k.highpass.a1), _mm256_set1_pd(k.highpass.a2)};
+
+	size_t common, longest;
+	group_extent(frames, first, 4 * sizeof...(V), common, longest);
+
+	Avx2Lanes s[sizeof...(V)];
+	(avx2_load(s[V], z, frames, split, first + 4 * V), ...);
+	for (size_t t = 0; t < longest; ++t) {
+		float *in = stage + first * kLaneStride + t;
+		const __m256d now = _mm256_set1_pd(static_cast<double>(t));
+		(avx2_step(f, s[V], in + 4 * V * kLaneStride, now, t < common, write_back), ...);
+	}
+	(avx2_store(s[V], z, energy, first + 4 * V), ...);
+}
+
+// Passes of 16 lanes, then the remaining 4, 8 or 12 in one pass
+LBM_TARGET_AVX2 void filter_avx2(const KWeighting &k, double (*z)[kStride], float *stage, const size_t *frames,
+				 const size_t *split, double (*energy)[kStride], size_t lanes, bool write_back)
+{
+	size_t g = 0;
+	for (; g + 16 <= lanes; g += 16) {
+		avx2_pass(k, z, stage, frames, split, energy, g, write_back, std::make_index_sequence<4>());
+	}
+	switch ((lanes - g) / 4) {
+	case 1:
+		avx2_pass(k, z, stage, frames, split, energy, g, write_back, std::make_index_sequence<1>());
+		break;
+	case 2:
+		avx2_pass(k, z, stage, frames, split, energy, g, write_back, std::make_index_sequence<2>());
+		break;
+	case 3:
+		avx2_pass(k, z, stage, frames, split, energy, g, write_back, std::make_index_sequence<3>());
+		break;
+	default:
+		break;
+	}
+}
+
+bool cpu_has_avx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+		return false; // OS does not save YMM state
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef LBM_SIMD_NEON
+struct NeonFilter {
+	float64x2_t sb0, sb1, sb2, sa1, sa2, hb0, hb1, hb2, ha1, ha2;
+};
+
+// Two lanes
+struct NeonLanes {
+	float64x2_t z0, z1, z2, z3, frames, split, head, tail;
+};
+
+inline void neon_load(NeonLanes &s, double (*z)[kStride], const size_t *frames, const size_t *split, size_t g)
+{
+	const double bounds[2] = {static_cast<double>(frames[g]), static_cast<double>(frames[g + 1])};
+	const double splits[2] = {static_cast<double>(split[g]), static_cast<double>(split[g + 1])};
+	s.z0 = vld1q_f64(&z[0][g]);
+	s.z1 = vld1q_f64(&z[1][g]);
+	s.z2 = vld1q_f64(&z[2][g]);
+	s.z3 = vld1q_f64(&z[3][g]);
+	s.frames = vld1q_f64(bounds);
+	s.split = vld1q_f64(splits);
+	s.head = vdupq_n_f64(0.0);
+	s.tail = vdupq_n_f64(0.0);
+}
+
+inline float64x2_t neon_mask(uint64x2_t mask, float64x2_t v)
+{
+	return vreinterpretq_f64_u64(vandq_u64(mask, vreinterpretq_u64_f64(v)));
+}
+
+inline void neon_step(const NeonFilter &f, NeonLanes &s, float *in, float64x2_t now, bool live, bool write_back)
+{
+	const float64x2_t x = vcombine_f64(vdup_n_f64(in[0]), vdup_n_f64(in[kLaneStride]));
+
+	const float64x2_t y = vaddq_f64(vmulq_f64(f.sb0, x), s.z0);
+	const float64x2_t n0 = vaddq_f64(vsubq_f64(vmulq_f64(f.sb1, x), vmulq_f64(f.sa1, y)), s.z1);
+	const float64x2_t n1 = vsubq_f64(vmulq_f64(f.sb2, x), vmulq_f64(f.sa2, y));
+
+	const float64x2_t w = vaddq_f64(vmulq_f64(f.hb0, y), s.z2);
+	const float64x2_t n2 = vaddq_f64(vsubq_f64(vmulq_f64(f.hb1, y), vmulq_f64(f.ha1, w)), s.z3);
+	const float64x2_t n3 = vsubq_f64(vmulq_f64(f.hb2, y), vmulq_f64(f.ha2, w));
+
+	if (write_back) {
+		in[0] = static_cast<float>(vgetq_lane_f64(w, 0));
+		in[kLaneStride] = static_cast<float>(vgetq_lane_f64(w, 1));
+	}
+
+	const float64x2_t ww = vmulq_f64(w, w);
+	const uint64x2_t in_head = vcltq_f64(now, s.split);
+	const uint64x2_t valid = vcltq_f64(now, s.frames);
+	s.head = vaddq_f64(s.head, neon_mask(in_head, ww));
+	s.tail = vaddq_f64(s.tail, neon_mask(vbicq_u64(valid, in_head), ww));
+
+	if (live) {
+		s.z0 = n0;
+		s.z1 = n1;
+		s.z2 = n2;
+		s.z3 = n3;
+	} else {
+		s.z0 = vbslq_f64(valid, n0, s.z0);
+		s.z1 = vbslq_f64(valid, n1, s.z1);
+		s.z2 = vbslq_f64(valid, n2, s.z2);
+		s.z3 = vbslq_f64(valid, n3, s.z3);
+	}
+}
+
+inline void neon_store(const NeonLanes &s, double (*z)[kStride], double (*energy)[kStride], size_t g)
+{
+	vst1q_f64(&z[0][g], s.z0);
+	vst1q_f64(&z[1][g], s.z1);
+	vst1q_f64(&z[2][g], s.z2);
+	vst1q_f64(&z[3][g], s.z3);
+	vst1q_f64(&energy[0][g], s.head);
+	vst1q_f64(&energy[1][g], s.tail);
+}
+
+template<size_t... V>
+void neon_pass(const KWeighting &k, double (*z)[kStride], float *stage, const size_t *frames,
+	       const size_t *split, double (*energy)[kStride], size_t first, bool write_back,
+	       std::index_sequence<V...>)
+{
+	const NeonFilter f{vdupq_n_f64(k.shelf.b0),    vdupq_n_f64(k.shelf.b1),    vdupq_n_f64(k.shelf.b2),
+			   vdupq_n_f64(k.shelf.a1),    vdupq_n_f64(k.shelf.a2),    vdupq_n_f64(k.highpass.b0),
+			   vdupq_n_f64(k.highpass.b1), vdupq_n_f64(k.highpass.b2), vdupq_n_f64(k.highpass.a1),
+			   vdupq_n_f64(k.highpass.a2)};
+
+	size_t common, longest;
+	group_extent(frames, first, 2 * sizeof...(V), common, longest);
+
+	NeonLanes s[sizeof...(V)];
+	(neon_load(s[V], z, frames, split, first + 2 * V), ...);
+	for (size_t t = 0; t < longest; ++t) {
+		float *in = stage + first * kLaneStride + t;
+		const float64x2_t now = vdupq_n_f64(static_cast<double>(t));
+		(neon_step(f, s[V], in + 2 * V * kLaneStride, now, t < common, write_back), ...);
+	}
+	(neon_store(s[V], z, energy, first + 2 * V), ...);
+}
+
+void filter_neon(const KWeighting &k, double (*z)[kStride], float *stage, const size_t *frames,
+		 const size_t *split, double (*energy)[kStride], size_t lanes, bool write_back)
+{
+	size_t g = 0;
+	for (; g + 8 <= lanes; g += 8) {
+		neon_pass(k, z, stage, frames, split, energy, g, write_back, std::make_index_sequence<4>());
+	}
+	if (g < lanes) {
+		neon_pass(k, z, stage, frames, split, energy, g, write_back, std::make_index_sequence<2>());
+	}
+}
+#endif
+
+} // namespace
+
+// === KWeighting ===
+
+KWeighting KWeighting::for_sample_rate(uint32_t sample_rate)
+{
+	const double sr = static_cast<double>(sample_rate);
+	KWeighting kw{};
+
+	// Stage 1: high shelf
+	double f0 = 1681.974450955533;
+	double gain_db = 3.999843853973347;
+	double q = 0.7071752369554196;
+	double k = std::tan(kPi * f0 / sr);
+	const double vh = std::pow(10.0, gain_db / 20.0);
+	const double vb = std::pow(vh, 0.4996667741545416);
+	double a0 = 1.0 + k / q + k * k;
+	kw.shelf.b0 = (vh + vb * k / q + k * k) / a0;
+	kw.shelf.b1 = 2.0 * (k * k - vh) / a0;
+	kw.shelf.b2 = (vh - vb * k / q + k * k) / a0;
+	kw.shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+	kw.shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+	// Stage 2: RLB high-pass; libebur128 leaves the numerator unnormalized, keep it for identical results
+	f0 = 38.13547087602444;
+	q = 0.5003270373238773;
+	k = std::tan(kPi * f0 / sr);
+	a0 = 1.0 + k / q + k * k;
+	kw.highpass.b0 = 1.0;
+	kw.highpass.b1 = -2.0;
+	kw.highpass.b2 = 1.0;
+	kw.highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+	kw.highpass.a2 = (1.0 - k / q + k * k) / a0;
+	return kw;
+}
+
+double KWeighting::filter(const float *samples, size_t frames, double z[4], double gain) const
+{
+	const Biquad s = shelf;
+	const Biquad h = highpass;
+	double z0 = z[0], z1 = z[1], z2 = z[2], z3 = z[3];
+
+	double energy = 0.0;
+	for (size_t i = 0; i < frames; ++i) {
+		const double x = samples[i] * gain;
+		const double y = s.b0 * x + z0;
+		z0 = s.b1 * x - s.a1 * y + z1;
+		z1 = s.b2 * x - s.a2 * y;
+
+		const double w = h.b0 * y + z2;
+		z2 = h.b1 * y - h.a1 * w + z3;
+		z3 = h.b2 * y - h.a2 * w;
+
+		energy += w * w;
+	}
+
+	// Flush denormals so silence does not slow the filter down
+	z[0] = std::fabs(z0) < 1e-30 ? 0.0 : z0;
+	z[1] = std::fabs(z1) < 1e-30 ? 0.0 : z1;
+	z[2] = std::fabs(z2) < 1e-30 ? 0.0 : z2;
+	z[3] = std::fabs(z3) < 1e-30 ? 0.0 : z3;
+	return energy;
+}
+
+// === SIMD dispatch ===
+
+const char *simd_level_name(SimdLevel level)
+{
+	switch (level) {
+	case SimdLevel::SSE2:
+		return "sse2";
+	case SimdLevel::AVX2:
+		return "avx2";
+	case SimdLevel::NEON:
+		return "neon";
+	default:
+		return "scalar";
+	}
+}
+
+bool simd_level_supported(SimdLevel level)
+{
+	switch (level) {
+	case SimdLevel::Scalar:
+		return true;
+#ifdef LBM_SIMD_SSE2
+	case SimdLevel::SSE2:
+		return true;
+#endif
+#ifdef LBM_SIMD_X86
+	case SimdLevel::AVX2: {
+		static const bool avx2 = cpu_has_avx2();
+		return avx2;
+	}
+#endif
+#ifdef LBM_SIMD_NEON
+	case SimdLevel::NEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+SimdLevel detect_simd_level()
+{
+	static constexpr SimdLevel kPreference[] = {SimdLevel::AVX2, SimdLevel::NEON, SimdLevel::SSE2};
+	for (SimdLevel level : kPreference) {
+		if (simd_level_supported(level)) {
+			return level;
+		}
+	}
+	return SimdLevel::Scalar;
+}
+
+// === KWeightingBank ===
+
+KWeightingBank::KWeightingBank() : stage_(std::make_unique<float[]>(kLaneStride * kMaxLanes))
+{
+	set_simd_level(detect_simd_level());
+	set_sample_rate(48000);
+}
+
+void KWeightingBank::set_sample_rate(uint32_t sample_rate)
+{
+	coeffs_ = KWeighting::for_sample_rate(sample_rate);
+	capacity_ = std::max<size_t>(1, std::min<size_t>(kStageFrames, (sample_rate + 5) / 10));
+	for (size_t lane = 0; lane < kMaxLanes; ++lane) {
+		reset_lane(lane);
+	}
+}
+
+void KWeightingBank::set_simd_level(SimdLevel level)
+{
+	if (!simd_level_supported(level)) {
+		level = detect_simd_level();
+	}
+	level_ = level;
+
+	switch (level) {
+#ifdef LBM_SIMD_SSE2
+	case SimdLevel::SSE2:
+		kernel_ = filter_sse2;
+		break;
+#endif
+#ifdef LBM_SIMD_X86
+	case SimdLevel::AVX2:
+		kernel_ = filter_avx2;
+		break;
+#endif
+#ifdef LBM_SIMD_NEON
+	case SimdLevel::NEON:
+		kernel_ = filter_neon;
+		break;
+#endif
+	default:
+		kernel_ = filter_scalar;
+		break;
+	}
+}
+
+void KWeightingBank::bind(size_t lane, LoudnessMeter *meter, const double *weights, uint32_t channels)
+{
+	if (channels == 0 || lane + channels > kMaxLanes) {
+		return;
+	}
+	reset_lane(lane);
+	for (uint32_t c = 0; c < channels; ++c) {
+		meters_[lane + c] = meter;
+		width_[lane + c] = 0;
+		gains_[lane + c] = weights ? static_cast<float>(std::sqrt(weights[c])) : 1.0f;
+	}
+	width_[lane] = meter ? channels : 0;
+
+	// Kernels walk whole passes of 4 lanes
+	lanes_ = 0;
+	for (size_t l = 0; l < kMaxLanes; ++l) {
+		if (meters_[l]) {
+			lanes_ = (l + 4) & ~static_cast<size_t>(3);
+		}
+	}
+}
+
+void KWeightingBank::unbind_all()
+{
+	for (size_t lane = 0; lane < kMaxLanes; ++lane) {
+		reset_lane(lane);
+		meters_[lane] = nullptr;
+		width_[lane] = 0;
+		taps_[lane] = nullptr;
+	}
+	lanes_ = 0;
+}
+
+void KWeightingBank::set_tap(size_t lane, KWeightingTap *tap)
+{
+	if (lane < kMaxLanes) {
+		taps_[lane] = tap;
+	}
+}
+
+void KWeightingBank::push(size_t lane, const float *samples, size_t frames, size_t stride)
+{
+	if (lane >= kMaxLanes || width_[lane] == 0) {
+		return;
+	}
+	if (stride == 0) {
+		stride = frames;
+	}
+
+	// Every lane of a stream stages the same amount, so the first one stands for all of them
+	const uint32_t channels = width_[lane];
+	while (frames > 0) {
+		if (fill_[lane] == capacity_) {
+			flush();
+		}
+		const size_t chunk = std::min(frames, capacity_ - fill_[lane]);
+		for (uint32_t c = 0; c < channels; ++c) {
+			const float *in = samples + c * stride;
+			float *out = stage_.get() + (lane + c) * kLaneStride + fill_[lane + c];
+			const float gain = gains_[lane + c];
+			if (gain == 1.0f) {
+				std::memcpy(out, in, chunk * sizeof(float));
+			} else {
+				for (size_t t = 0; t < chunk; ++t) {
+					out[t] = in[t] * gain;
+				}
+			}
+			fill_[lane + c] += chunk;
+		}
+		samples += chunk;
+		frames -= chunk;
+	}
+}
+
+void KWeightingBank::flush()
+{
+	bool staged = false;
+	bool tapped = false;
+	for (size_t lane = 0; lane < lanes_; ++lane) {
+		split_[lane] = fill_[lane] > 0 ? std::min(fill_[lane], meters_[lane]->frames_to_boundary()) : 0;
+		staged = staged || fill_[lane] > 0;
+		tapped = tapped || (fill_[lane] > 0 && taps_[lane]);
+	}
+	if (!staged) {
+		return;
+	}
+
+	// Idle lanes run through the kernel unmasked; put their state back afterwards
+	double idle[4][kMaxLanes];
+	for (size_t k = 0; k < 4; ++k) {
+		for (size_t lane = 0; lane < lanes_; ++lane) {
+			idle[k][lane] = z_[k][lane];
+		}
+	}
+
+	kernel_(coeffs_, z_, stage_.get(), fill_, split_, energy_, lanes_, tapped);
+
+	for (size_t lane = 0; lane < lanes_; ++lane) {
+		if (fill_[lane] == 0) {
+			for (size_t k = 0; k < 4; ++k) {
+				z_[k][lane] = idle[k][lane];
+			}
+		}
+	}
+
+	// A stream's energy is the sum over its channels; capacity_ keeps the tail inside the next sub-block
+	for (size_t lane = 0; lane < lanes_; ++lane) {
+		if (width_[lane] == 0 || fill_[lane] == 0) {
+			continue;
+		}
+		double energy[2] = {0.0, 0.0};
+		for (size_t c = lane; c < lane + width_[lane]; ++c) {
+			energy[0] += energy_[0][c];
+			energy[1] += energy_[1][c];
+		}
+		meters_[lane]->add_energy(energy[0], split_[lane]);
+		if (fill_[lane] > split_[lane]) {
+			meters_[lane]->add_energy(energy[1], fill_[lane] - split_[lane]);
+		}
+		if (taps_[lane]) {
+			taps_[lane]->on_weighted(lane, stage_.get() + lane * kLaneStride, kLaneStride, fill_[lane]);
+		}
+	}
+	std::fill(fill_, fill_ + lanes_, size_t{0});
+
+	// Flush denormals so silence does not slow the filter down
+	for (auto &state : z_) {
+		for (size_t lane = 0; lane < lanes_; ++lane) {
+			if (std::fabs(state[lane]) < 1e-30) {
+				state[lane] = 0.0;
+			}
+		}
+	}
+}
+
+void KWeightingBank::reset_lane(size_t lane)
+{
+	if (lane >= kMaxLanes) {
+		return;
+	}
+	const size_t end = lane + std::max<size_t>(width_[lane], 1);
+	for (size_t l = lane; l < end; ++l) {
+		for (auto &state : z_) {
+			state[l] = 0.0;
+		}
+		fill_[l] = 0;
+	}
+}
+
+} // namespace lbm
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "audio-frame.h"
+#include "channel-layout.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace lbm {
+
+class LoudnessMeter;
+
+// One second-order section (a0 normalized to 1)
+struct Biquad {
+	double b0, b1, b2, a1, a2;
+};
+
+// BS.1770 K-weighting: high shelf (head model) followed by the RLB high-pass
+struct KWeighting {
+	Biquad shelf;
+	Biquad highpass;
+
+	// Coefficients for any sample rate, derived exactly as libebur128 does
+	static KWeighting for_sample_rate(uint32_t sample_rate);
+
+	// Scalar reference: filter `frames` samples scaled by `gain` with the state `z` (transposed direct form II,
+	// two values per stage) and return the energy (sum of squares) of the output
+	double filter(const float *samples, size_t frames, double z[4], double gain = 1.0) const;
+};
+
+// Instruction sets the filter bank can run on
+enum class SimdLevel { Scalar, SSE2, AVX2, NEON };
+
+const char *simd_level_name(SimdLevel level);
+
+// Whether this build and CPU can run `level`
+bool simd_level_supported(SimdLevel level);
+
+// Best level supported by this CPU (checked once at runtime)
+SimdLevel detect_simd_level();
+
+// Receives a stream's K-weighted samples from KWeightingBank::flush(), after its meter has been fed
+class KWeightingTap {
+public:
+	// `lane` is the stream's first lane; channel c starts at weighted + c * stride, already scaled by its
+	// weight. `weighted` is valid for the duration of the call; the callee must not push to or flush the bank.
+	virtual void on_weighted(size_t lane, const float *weighted, size_t stride, size_t frames) = 0;
+
+protected:
+	~KWeightingTap() = default;
+};
+
+// K-weighting for many independent streams in one vectorized pass
+//
+// Each channel of a stream is a lane; a stream's lanes are consecutive and bound to one LoudnessMeter.
+// push() only stages a stream's samples, scaled per channel by the square root of its BS.1770 weight G so
+// the squared outputs are already weighted; flush() filters everything staged with the state of 2 (SSE2 /
+// NEON) or 4 (AVX2) lanes held in one register, so all lanes advance in the same loop, and adds each
+// stream's summed channel energy to its meter, split at the meter's next 100 ms boundary. Streams may stage
+// different amounts; a lane stops advancing once its own samples are used up.
+//
+// The filter runs in double precision so the results match libebur128 (see lbm-loudness-bench).
+// Storage is allocated by the constructor; push() and flush() never allocate. Not thread-safe.
+class KWeightingBank {
+public:
+	// Voice, BGM, mix, every BGM source and every output track, each with up to kMaxChannels channels
+	static constexpr size_t kMaxLanes = 17 * kMaxChannels;
+	static constexpr size_t kStageFrames = AudioFrame::kMaxSamples; // Per lane; push() flushes when full
+
+	// Staging stride, padded by a cache line so the lanes read together do not all map to the same L1 set
+	static constexpr size_t kLaneStride = kStageFrames + 16;
+
+	KWeightingBank();
+
+	// Non-copyable
+	KWeightingBank(const KWeightingBank &) = delete;
+	KWeightingBank &operator=(const KWeightingBank &) = delete;
+
+	// Recompute the filter and clear every lane (bound meters must use the same rate)
+	void set_sample_rate(uint32_t sample_rate);
+
+	// Force a kernel (clamped to what the CPU supports); defaults to detect_simd_level()
+	void set_simd_level(SimdLevel level);
+	SimdLevel simd_level() const { return level_; }
+
+	// Route a stream of `channels` lanes starting at `lane` to `meter` (nullptr unbinds them)
+	// `weights` holds the channel weights G (nullptr: all 1)
+	void bind(size_t lane, LoudnessMeter *meter, const double *weights = nullptr, uint32_t channels = 1);
+
+	// Unbind every stream (before binding them again for another channel count)
+	void unbind_all();
+
+	// Also hand a bound stream's filtered samples to `tap` on every flush (nullptr removes it)
+	void set_tap(size_t lane, KWeightingTap *tap);
+
+	// Queue samples for the stream starting at `lane`
+	// Channel c starts at samples + c * stride (stride 0: the planes are `frames` apart)
+	void push(size_t lane, const float *samples, size_t frames, size_t stride = 0);
+
+	// Filter all staged samples and feed the meters
+	void flush();
+
+	// Drop the staged samples and filter state of the stream starting at `lane` (the caller resets the meter)
+	void reset_lane(size_t lane);
+
+private:
+	// Filters lanes [0, lanes) in passes of 4; lane l advances frames[l] samples and sums the squared output
+	// of samples before split[l] into energy[0][l] and the rest into energy[1][l]. With write_back the output
+	// overwrites the staged input. Lanes with no frames may be left with any state.
+	using Kernel = void (*)(const KWeighting &coeffs, double (*z)[kMaxLanes], float *stage, const size_t *frames,
+				const size_t *split, double (*energy)[kMaxLanes], size_t lanes, bool write_back);
+
+	KWeighting coeffs_{};
+	SimdLevel level_{SimdLevel::Scalar};
+	Kernel kernel_{nullptr};
+	size_t lanes_{0}; // Bound lane count rounded up to the widest vector
+
+	// Filter state, structure of arrays: z_[k][lane]
+	alignas(32) double z_[4][kMaxLanes]{};
+
+	// Staged samples: stage_[lane * kLaneStride + t]
+	std::unique_ptr<float[]> stage_;
+	size_t capacity_{kStageFrames}; // Never more than one sub-block, so a flush crosses at most one boundary
+	size_t fill_[kMaxLanes]{};
+	size_t split_[kMaxLanes]{};
+	alignas(32) double energy_[2][kMaxLanes]{};
+	LoudnessMeter *meters_[kMaxLanes]{}; // Every lane of a stream points to its meter
+	uint32_t width_[kMaxLanes]{};        // Channel count on a stream's first lane, 0 elsewhere
+	float gains_[kMaxLanes]{};           // sqrt(G)
+	KWeightingTap *taps_[kMaxLanes]{};
+};
+
+} // namespace lbm
@@ -0,0 +1,1306 @@
+#include "loudness-analyzer.h"
+#include "audio-kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace lbm {
+
+namespace {
+
+// Copy a block of `channels` planes `frames` apart into a queue reservation, measuring it on the way (and
+// splitting its energy at the hop ends in `hops`, if given)
+BlockStats copy_planes(const float *samples, uint32_t channels, float *dest, uint32_t frames,
+		       HopEnergy *hops = nullptr)
+{
+	const float *planes[kMaxChannels];
+	for (uint32_t c = 0; c < channels; ++c) {
+		planes[c] = samples + static_cast<size_t>(c) * frames;
+	}
+	return hops ? kernels::capture_planes(planes, channels, dest, frames, 1.0f, *hops)
+		    : kernels::capture_planes(planes, channels, dest, frames, 1.0f);
+}
+
+// Clip judgment of a true peak in dBTP
+Status clip_status_of(double true_peak_dbtp)
+{
+	if (true_peak_dbtp >= AnalysisConfig::kClipBadThreshold) {
+		return Status::BAD;
+	}
+	if (true_peak_dbtp >= AnalysisConfig::kClipWarnThreshold) {
+		return Status::WARN;
+	}
+	return Status::OK;
+}
+
+} // namespace
+
+LoudnessAnalyzer::LoudnessAnalyzer(double queue_seconds) : queue_seconds_(queue_seconds)
+{
+	mix_gate_.resize(AudioFrame::kMaxSamples);
+	allocate_queues(); // The meters are bound to their lanes by start() / start_offline()
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer()
+{
+	stop();
+}
+
+void LoudnessAnalyzer::start()
+{
+	if (running_.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	init_loudness_meters(sample_rate_.load(std::memory_order_relaxed));
+	running_.store(true, std::memory_order_release);
+	worker_thread_ = std::thread(&LoudnessAnalyzer::worker_loop, this);
+}
+
+void LoudnessAnalyzer::stop()
+{
+	if (!running_.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	running_.store(false, std::memory_order_release);
+	wakeup_.wake();
+	if (worker_thread_.joinable()) {
+		worker_thread_.join();
+	}
+
+	// Commands the worker did not get to; the calling thread is the consumer now
+	apply_commands();
+}
+
+bool LoudnessAnalyzer::push_voice_frame(const float *samples, uint32_t frames)
+{
+	if (!samples || frames == 0) {
+		return false;
+	}
+	if (frames > AudioFrame::kMaxSamples) {
+		voice_counters_.count_drop(DropReason::Oversized, frames);
+		return false;
+	}
+
+	// Copy straight into the queue, measuring the block on the way
+	float *dest = reserve_voice_frame(frames);
+	if (!dest) {
+		return false;
+	}
+	HopEnergy hops = next_voice_hops();
+	commit_voice_frame(frames, copy_planes(samples, voice_queue_.channels(), dest, frames, &hops), 0, &hops);
+	return true;
+}
+
+float *LoudnessAnalyzer::reserve_voice_frame(uint32_t frames)
+{
+	float *samples = voice_queue_.try_reserve(frames);
+	if (!samples) {
+		voice_counters_.count_drop(DropReason::QueueFull, frames);
+	}
+	return samples;
+}
+
+HopEnergy LoudnessAnalyzer::next_voice_hops() const
+{
+	HopEnergy hops;
+	hops.hop = VoiceActivityDetector::hop_samples(sample_rate_.load(std::memory_order_relaxed));
+	hops.first = hops.hop - voice_hop_phase_ % hops.hop;
+	return hops;
+}
+
+void LoudnessAnalyzer::commit_voice_frame(uint32_t frames, const BlockStats &stats, uint64_t timestamp,
+					  const HopEnergy *hops)
+{
+	voice_counters_.count_push(frames);
+
+	// Update peak (in audio callback for accuracy)
+	voice_peak_.store(stats.peak, std::memory_order_relaxed);
+
+	// The worker's VAD sees every committed frame, so counting them keeps the hop ends in step with it
+	const uint32_t hop =
+		hops ? hops->hop : VoiceActivityDetector::hop_samples(sample_rate_.load(std::memory_order_relaxed));
+	voice_hop_phase_ = (voice_hop_phase_ % hop + frames) % hop;
+
+	if (voice_queue_.commit(frames, stats, timestamp, 0, hops)) {
+		wakeup_.notify();
+	}
+}
+
+int LoudnessAnalyzer::add_bgm_input()
+{
+	for (;;) {
+		bool retiring = false;
+		for (int i = 0; i < kMaxBgmInputs; ++i) {
+			BgmInput &input = bgm_inputs_[i];
+			InputState state = input.state.load(std::memory_order_acquire);
+			if (state != InputState::Free) {
+				retiring |= (state == InputState::Retiring);
+				continue;
+			}
+
+			// A Free slot is touched by neither producer nor consumer, so it can be resized here
+			input.queue.allocate(queue_samples_, queue_headers_, channels_);
+			input.counters.reset();
+			input.state.store(InputState::Active, std::memory_order_release);
+			return i;
+		}
+
+		if (!retiring) {
+			return -1;
+		}
+
+		// A recently removed input is about to be freed by the worker (woken by remove_bgm_input)
+		if (running_.load(std::memory_order_relaxed)) {
+			std::this_thread::yield();
+		} else {
+			retire_bgm_inputs();
+		}
+	}
+}
+
+void LoudnessAnalyzer::remove_bgm_input(int input)
+{
+	if (input < 0 || input >= kMaxBgmInputs) {
+		return;
+	}
+
+	BgmInput &slot = bgm_inputs_[input];
+	if (slot.state.load(std::memory_order_relaxed) != InputState::Active) {
+		return;
+	}
+
+	slot.state.store(InputState::Retiring, std::memory_order_release);
+
+	// Without a worker the calling thread is the only consumer
+	if (running_.load(std::memory_order_relaxed)) {
+		wakeup_.wake();
+	} else {
+		retire_bgm_inputs();
+	}
+}
+
+void LoudnessAnalyzer::retire_bgm_inputs()
+{
+	for (int n = 0; n < kMaxBgmInputs; ++n) {
+		BgmInput &input = bgm_inputs_[n];
+		if (input.state.load(std::memory_order_acquire) == InputState::Retiring) {
+			leave_bgm_input(n);
+			input.queue.discard();
+			input.state.store(InputState::Free, std::memory_order_release);
+		}
+	}
+}
+
+void LoudnessAnalyzer::count_bgm_drop(int input, DropReason reason, uint32_t frames)
+{
+	if (input >= 0 && input < kMaxBgmInputs) {
+		bgm_inputs_[input].counters.count_drop(reason, frames);
+	}
+}
+
+StreamTelemetry LoudnessAnalyzer::bgm_telemetry(int input) const
+{
+	if (input < 0 || input >= kMaxBgmInputs) {
+		return StreamTelemetry{};
+	}
+	return bgm_inputs_[input].counters.snapshot();
+}
+
+bool LoudnessAnalyzer::push_bgm_frame(int input, const float *samples, uint32_t frames)
+{
+	if (!samples || frames == 0) {
+		return false;
+	}
+	if (frames > AudioFrame::kMaxSamples) {
+		count_bgm_drop(input, DropReason::Oversized, frames);
+		return false;
+	}
+
+	// Copy straight into the queue, measuring the block on the way
+	float *dest = reserve_bgm_frame(input, frames);
+	if (!dest) {
+		return false;
+	}
+	commit_bgm_frame(input, frames, copy_planes(samples, bgm_inputs_[input].queue.channels(), dest, frames));
+	return true;
+}
+
+float *LoudnessAnalyzer::reserve_bgm_frame(int input, uint32_t frames)
+{
+	if (input < 0 || input >= kMaxBgmInputs) {
+		return nullptr;
+	}
+
+	BgmInput &slot = bgm_inputs_[input];
+	float *samples = slot.queue.try_reserve(frames);
+	if (!samples) {
+		slot.counters.count_drop(DropReason::QueueFull, frames);
+	}
+	return samples;
+}
+
+void LoudnessAnalyzer::commit_bgm_frame(int input, uint32_t frames, const BlockStats &stats, uint64_t timestamp)
+{
+	bgm_inputs_[input].counters.count_push(frames);
+
+	// Per-source peak; the summed BGM peak is taken from the bus output
+	bgm_inputs_[input].peak.store(stats.peak, std::memory_order_relaxed);
+
+	if (bgm_inputs_[input].queue.commit(frames, stats, timestamp, static_cast<uint32_t>(input))) {
+		wakeup_.notify();
+	}
+}
+
+bool LoudnessAnalyzer::add_track_input(int track)
+{
+	if (track < 0 || track >= kMaxTrackInputs) {
+		return false;
+	}
+
+	TrackInput &slot = track_inputs_[track];
+	for (;;) {
+		const InputState state = slot.state.load(std::memory_order_acquire);
+		if (state == InputState::Active) {
+			return false;
+		}
+		if (state == InputState::Free) {
+			break;
+		}
+
+		// Removed a moment ago and about to be freed by the worker (woken by remove_track_input)
+		if (running_.load(std::memory_order_relaxed)) {
+			std::this_thread::yield();
+		} else {
+			retire_track_inputs();
+		}
+	}
+
+	// A Free slot is touched by neither producer nor consumer, so it can be resized here
+	slot.queue.allocate(queue_samples_, queue_headers_, channels_);
+	slot.counters.reset();
+	slot.state.store(InputState::Active, std::memory_order_release);
+	return true;
+}
+
+void LoudnessAnalyzer::remove_track_input(int track)
+{
+	if (track < 0 || track >= kMaxTrackInputs) {
+		return;
+	}
+
+	TrackInput &slot = track_inputs_[track];
+	if (slot.state.load(std::memory_order_relaxed) != InputState::Active) {
+		return;
+	}
+
+	slot.state.store(InputState::Retiring, std::memory_order_release);
+
+	// Without a worker the calling thread is the only consumer
+	if (running_.load(std::memory_order_relaxed)) {
+		wakeup_.wake();
+	} else {
+		retire_track_inputs();
+	}
+}
+
+void LoudnessAnalyzer::retire_track_inputs()
+{
+	for (int n = 0; n < kMaxTrackInputs; ++n) {
+		TrackInput &slot = track_inputs_[n];
+		if (slot.state.load(std::memory_order_acquire) == InputState::Retiring) {
+			leave_track_input(n);
+			slot.queue.discard();
+			slot.state.store(InputState::Free, std::memory_order_release);
+		}
+	}
+}
+
+void LoudnessAnalyzer::count_track_drop(int track, DropReason reason, uint32_t frames)
+{
+	if (track >= 0 && track < kMaxTrackInputs) {
+		track_inputs_[track].counters.count_drop(reason, frames);
+	}
+}
+
+StreamTelemetry LoudnessAnalyzer::track_telemetry(int track) const
+{
+	if (track < 0 || track >= kMaxTrackInputs) {
+		return StreamTelemetry{};
+	}
+	return track_inputs_[track].counters.snapshot();
+}
+
+bool LoudnessAnalyzer::push_track_frame(int track, const float *samples, uint32_t frames)
+{
+	if (!samples || frames == 0) {
+		return false;
+	}
+	if (frames > AudioFrame::kMaxSamples) {
+		count_track_drop(track, DropReason::Oversized, frames);
+		return false;
+	}
+
+	// Copy straight into the queue, measuring the block on the way
+	float *dest = reserve_track_frame(track, frames);
+	if (!dest) {
+		return false;
+	}
+	commit_track_frame(track, frames, copy_planes(samples, track_inputs_[track].queue.channels(), dest, frames));
+	return true;
+}
+
+float *LoudnessAnalyzer::reserve_track_frame(int track, uint32_t frames)
+{
+	if (track < 0 || track >= kMaxTrackInputs) {
+		return nullptr;
+	}
+
+	TrackInput &slot = track_inputs_[track];
+	float *samples = slot.queue.try_reserve(frames);
+	if (!samples) {
+		slot.counters.count_drop(DropReason::QueueFull, frames);
+	}
+	return samples;
+}
+
+void LoudnessAnalyzer::commit_track_frame(int track, uint32_t frames, const BlockStats &stats)
+{
+	TrackInput &slot = track_inputs_[track];
+	slot.counters.count_push(frames);
+	slot.peak.store(stats.peak, std::memory_order_relaxed);
+
+	if (slot.queue.commit(frames, stats, 0, static_cast<uint32_t>(track))) {
+		wakeup_.notify();
+	}
+}
+
+void LoudnessAnalyzer::allocate_queues()
+{
+	// Memory follows the latency budget instead of kMaxSamples x slot count;
+	// always keep room for two maximum-size blocks
+	const uint32_t sr = sample_rate_.load(std::memory_order_relaxed);
+	queue_samples_ = std::max(static_cast<size_t>(queue_seconds_ * sr), 2 * AudioFrame::kMaxSamples);
+	queue_headers_ = queue_samples_ / kMinQueueBlock;
+
+	const ChannelLayout layout = layout_.load(std::memory_order_relaxed);
+	channels_ = channel_count(layout);
+	for (uint32_t c = 0; c < kMaxChannels; ++c) {
+		channel_weights_[c] = channel_weight(layout, c);
+	}
+
+	voice_queue_.allocate(queue_samples_, queue_headers_, channels_, true);
+	voice_hop_phase_ = 0;
+	voice_true_peak_.set_channels(channels_);
+	bgm_true_peak_.set_channels(channels_);
+	mix_true_peak_.set_channels(channels_);
+	for (BgmInput &input : bgm_inputs_) {
+		if (input.state.load(std::memory_order_relaxed) != InputState::Free) {
+			input.queue.allocate(queue_samples_, queue_headers_, channels_);
+		}
+		input.true_peak.set_channels(channels_);
+	}
+	for (TrackInput &track : track_inputs_) {
+		if (track.state.load(std::memory_order_relaxed) != InputState::Free) {
+			track.queue.allocate(queue_samples_, queue_headers_, channels_);
+		}
+		track.true_peak.set_channels(channels_);
+	}
+	configure_buses(sr);
+}
+
+void LoudnessAnalyzer::configure_buses(uint32_t sample_rate)
+{
+	for (BgmInput &input : bgm_inputs_) {
+		input.joined = false; // Rejoined on the next batch
+	}
+
+	const uint64_t max_skew = static_cast<uint64_t>(kMaxSkewSeconds * sample_rate);
+	const uint32_t preroll = static_cast<uint32_t>(kPrerollSeconds * sample_rate);
+	bgm_bus_.configure(max_skew, AudioFrame::kMaxSamples, channels_);
+	mix_bus_.configure(max_skew, AudioFrame::kMaxSamples, channels_, preroll);
+	mix_bus_.add_input(kMixVoice, 0);
+	weighted_mix_bus_.configure(max_skew, AudioFrame::kMaxSamples, channels_, preroll);
+	weighted_mix_bus_.add_input(kMixVoice, 0);
+	voice_preroll_.configure(preroll, channels_);
+	bgm_block_.assign(AudioFrame::kMaxSamples * channels_, 0.0f);
+	mix_block_.assign(AudioFrame::kMaxSamples * channels_, 0.0f);
+	timeline_.reset(sample_rate);
+}
+
+void LoudnessAnalyzer::set_sample_rate(uint32_t sample_rate)
+{
+	if (sample_rate == sample_rate_.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	sample_rate_.store(sample_rate, std::memory_order_relaxed);
+	if (running_.load(std::memory_order_relaxed)) {
+		send_command({Command::Type::SetSampleRate, sample_rate});
+		return;
+	}
+
+	// No consumer is running, so the queues can be resized too; the meters follow at the next start
+	vad_.set_sample_rate(sample_rate);
+	allocate_queues();
+}
+
+void LoudnessAnalyzer::set_channel_layout(ChannelLayout layout)
+{
+	// Producers write whole planar blocks into the queues, so the layout cannot change under them
+	if (layout == channel_layout() || running_.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	layout_.store(layout, std::memory_order_relaxed);
+	allocate_queues();
+}
+
+void LoudnessAnalyzer::set_loudness_window(LoudnessWindow window)
+{
+	if (window == loudness_window_.exchange(window, std::memory_order_relaxed)) {
+		return;
+	}
+	send_command({Command::Type::SetWindow, static_cast<uint32_t>(window)});
+}
+
+void LoudnessAnalyzer::reset_stream(Stream stream)
+{
+	send_command({Command::Type::ResetStream, static_cast<uint32_t>(stream)});
+}
+
+void LoudnessAnalyzer::warm_voice(const WarmupWindow &window)
+{
+	if (window.sample_rate() != sample_rate() || window.layout() != channel_layout()) {
+		return;
+	}
+
+	// Mean power per channel against the VAD threshold, as the VAD judges its hops (on K-weighted energy here)
+	const double floor = std::pow(10.0, vad_.threshold() / 10.0) * window.block_samples() * channels();
+	double voiced[LoudnessMeter::kShorttermBlocks]; // Newest first
+	uint32_t count = 0;
+	for (size_t age = 0; age < window.size() && count < LoudnessMeter::kShorttermBlocks; ++age) {
+		if (window.block(age) >= floor) {
+			voiced[count++] = window.block(age);
+		}
+	}
+
+	Command command{Command::Type::WarmVoice, 0};
+	for (uint32_t i = 0; i < count; ++i) {
+		command.energies[i] = voiced[count - 1 - i];
+	}
+	command.blocks = count;
+	command.position = voice_queue_.committed_samples(); // No voice producer is attached now
+	send_command(command);
+}
+
+void LoudnessAnalyzer::warm_bgm_input(int input, const WarmupWindow &window)
+{
+	if (input < 0 || input >= kMaxBgmInputs || window.sample_rate() != sample_rate() ||
+	    window.layout() != channel_layout()) {
+		return;
+	}
+
+	Command command{Command::Type::WarmBgm, static_cast<uint32_t>(input)};
+	const size_t blocks = std::min(window.size(), LoudnessMeter::kShorttermBlocks);
+	for (size_t i = 0; i < blocks; ++i) {
+		command.energies[i] = window.block(blocks - 1 - i);
+	}
+	command.blocks = static_cast<uint32_t>(blocks);
+	send_command(command);
+}
+
+void LoudnessAnalyzer::send_command(const Command &command)
+{
+	// Without a worker the calling thread is the only consumer
+	if (!running_.load(std::memory_order_relaxed)) {
+		apply_command(command);
+		return;
+	}
+
+	// Only full if the worker is stalled; it drains the queue before every batch
+	while (!commands_.try_push(command)) {
+		wakeup_.wake();
+		std::this_thread::yield();
+	}
+	wakeup_.wake();
+}
+
+void LoudnessAnalyzer::apply_commands()
+{
+	Command command;
+	while (commands_.try_pop(command)) {
+		apply_command(command);
+	}
+}
+
+void LoudnessAnalyzer::apply_command(const Command &command)
+{
+	switch (command.type) {
+	case Command::Type::SetSampleRate:
+		// The queues keep their size; everything downstream restarts at the new rate
+		vad_.set_sample_rate(command.value);
+		configure_buses(command.value);
+		init_loudness_meters(command.value);
+		reset_meters(Stream::All);
+		break;
+	case Command::Type::SetWindow:
+		window_ = static_cast<LoudnessWindow>(command.value);
+		break;
+	case Command::Type::ResetStream:
+		reset_meters(static_cast<Stream>(command.value));
+		break;
+	case Command::Type::WarmVoice:
+		// The old source's blocks still queued would land on the new source's window; nothing is staged
+		// between batches, so the lane restarts with the new source
+		voice_queue_.discard_before(command.position);
+		kweighting_.reset_lane(lane(kStreamVoice));
+		voice_meter_.seed(command.energies, command.blocks);
+		voice_released_ = false;
+		results_.voice_lufs.store(window_loudness(voice_meter_), std::memory_order_relaxed);
+		break;
+	case Command::Type::WarmBgm: {
+		BgmInput &slot = bgm_inputs_[command.value];
+		if (slot.state.load(std::memory_order_acquire) != InputState::Active) {
+			break;
+		}
+		if (!slot.joined) {
+			join_bgm_input(static_cast<int>(command.value)); // Would restart the meter on the next batch
+		}
+		slot.loudness.seed(command.energies, command.blocks);
+		bgm_meter_.merge(command.energies, command.blocks);
+		results_.bgm_sources[command.value].lufs.store(window_loudness(slot.loudness),
+								std::memory_order_relaxed);
+		results_.bgm_lufs.store(window_loudness(bgm_meter_), std::memory_order_relaxed);
+		break;
+	}
+	}
+}
+
+void LoudnessAnalyzer::start_offline()
+{
+	if (running_.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	init_loudness_meters(sample_rate_.load(std::memory_order_relaxed));
+}
+
+size_t LoudnessAnalyzer::process_pending()
+{
+	// The worker thread is the only consumer while it is running
+	if (running_.load(std::memory_order_relaxed)) {
+		return 0;
+	}
+
+	uint64_t before = processed_frames_.load(std::memory_order_relaxed);
+	while (process_batch()) {
+	}
+	return static_cast<size_t>(processed_frames_.load(std::memory_order_relaxed) - before);
+}
+
+void LoudnessAnalyzer::worker_loop()
+{
+	while (running_.load(std::memory_order_acquire)) {
+		if (process_batch()) {
+			continue;
+		}
+
+		// Blocks often arrive back to back (several sources, OBS tick bursts): spin briefly first,
+		// adapting the spin length to whether spinning has been paying off
+		bool found = false;
+		for (uint32_t i = 0; i < spin_limit_; ++i) {
+			std::this_thread::yield();
+			if (has_pending_work()) {
+				found = true;
+				break;
+			}
+		}
+		if (found) {
+			spin_limit_ = std::min(spin_limit_ * 2, kMaxSpin);
+			continue;
+		}
+		spin_limit_ = std::max(spin_limit_ / 2, kMinSpin);
+
+		// Sleep until a producer publishes into an empty queue
+		wakeup_.prepare_wait();
+		if (has_pending_work() || !running_.load(std::memory_order_acquire)) {
+			wakeup_.cancel_wait();
+			continue;
+		}
+		wakeup_.wait_for(std::chrono::milliseconds(kWakeupTimeoutMs));
+	}
+}
+
+bool LoudnessAnalyzer::has_pending_work() const
+{
+	if (!voice_queue_.empty() || !commands_.empty()) {
+		return true;
+	}
+	for (const BgmInput &input : bgm_inputs_) {
+		InputState state = input.state.load(std::memory_order_acquire);
+		if (state == InputState::Retiring || (state == InputState::Active && !input.queue.empty())) {
+			return true;
+		}
+	}
+	for (const TrackInput &track : track_inputs_) {
+		InputState state = track.state.load(std::memory_order_acquire);
+		if (state == InputState::Retiring || (state == InputState::Active && !track.queue.empty())) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LoudnessAnalyzer::process_batch()
+{
+	// Control changes land between batches, where no block is half measured
+	apply_commands();
+	retire_bgm_inputs();
+	retire_track_inputs();
+
+	// Take the whole backlog (up to kMaxBatch blocks per queue) with one acquire per queue
+	AudioFrame voice_frames[kMaxBatch];
+	voice_counters_.update_lag(voice_queue_.queued_samples());
+	const size_t voice_count = voice_queue_.try_peek_batch(voice_frames, kMaxBatch);
+
+	// Every BGM source is consumed from its own queue
+	AudioFrame bgm_frames[kMaxBgmInputs][kMaxBatch];
+	size_t bgm_counts[kMaxBgmInputs]{};
+	size_t bgm_total = 0;
+	size_t count = voice_count;
+	for (int n = 0; n < kMaxBgmInputs; ++n) {
+		BgmInput &input = bgm_inputs_[n];
+		if (input.state.load(std::memory_order_acquire) != InputState::Active) {
+			continue;
+		}
+		if (!input.joined) {
+			join_bgm_input(n);
+		}
+		input.counters.update_lag(input.queue.queued_samples());
+		bgm_counts[n] = input.queue.try_peek_batch(bgm_frames[n], kMaxBatch);
+		bgm_total += bgm_counts[n];
+		count = std::max(count, bgm_counts[n]);
+	}
+
+	// Output tracks likewise, each measured on its own
+	AudioFrame track_frames[kMaxTrackInputs][kMaxBatch];
+	size_t track_counts[kMaxTrackInputs]{};
+	size_t track_total = 0;
+	for (int n = 0; n < kMaxTrackInputs; ++n) {
+		TrackInput &track = track_inputs_[n];
+		if (track.state.load(std::memory_order_acquire) != InputState::Active) {
+			continue;
+		}
+		if (!track.joined) {
+			join_track_input(n);
+		}
+		track.counters.update_lag(track.queue.queued_samples());
+		track_counts[n] = track.queue.try_peek_batch(track_frames[n], kMaxBatch);
+		track_total += track_counts[n];
+		count = std::max(count, track_counts[n]);
+	}
+
+	if (voice_count == 0 && bgm_total == 0 && track_total == 0) {
+		return false;
+	}
+
+	// Feed the states in the same voice/BGM interleaving as one-at-a-time processing
+	voice_dirty_ = bgm_dirty_ = mix_dirty_ = false;
+	voice_true_peak_max_ = bgm_true_peak_max_ = mix_true_peak_max_ = 0.0f;
+	for (BgmInput &input : bgm_inputs_) {
+		input.true_peak_max = 0.0f;
+	}
+	for (TrackInput &track : track_inputs_) {
+		track.true_peak_max = 0.0f;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		if (i < voice_count) {
+			process_voice(voice_frames[i]);
+		}
+		for (int n = 0; n < kMaxBgmInputs; ++n) {
+			if (i < bgm_counts[n]) {
+				process_bgm(n, bgm_frames[n][i]);
+			}
+		}
+		for (int n = 0; n < kMaxTrackInputs; ++n) {
+			if (i < track_counts[n]) {
+				process_track(n, track_frames[n][i]);
+			}
+		}
+		process_bgm_bus();
+		if (derived_mix_) {
+			// Bring weighted_mix_bus_ level with mix_bus_
+			kweighting_.flush();
+		}
+		process_mix_bus();
+		if (derived_mix_) {
+			process_weighted_mix_bus();
+		}
+	}
+	kweighting_.flush();
+	voice_queue_.release(voice_count);
+	for (int n = 0; n < kMaxBgmInputs; ++n) {
+		bgm_inputs_[n].queue.release(bgm_counts[n]);
+	}
+	for (int n = 0; n < kMaxTrackInputs; ++n) {
+		track_inputs_[n].queue.release(track_counts[n]);
+	}
+
+	// Publish metrics and judgments once per batch
+	if (voice_dirty_) {
+		update_voice_metrics();
+	}
+	if (bgm_dirty_) {
+		update_bgm_metrics();
+	}
+	if (mix_dirty_) {
+		update_mix_metrics();
+	}
+	if (track_total > 0) {
+		update_track_metrics();
+	}
+
+	update_balance_judgment();
+	update_mix_judgment();
+	update_clip_judgment();
+
+	processed_frames_.fetch_add(voice_count + bgm_total + track_total, std::memory_order_release);
+	return true;
+}
+
+void LoudnessAnalyzer::process_voice(const AudioFrame &frame)
+{
+	voice_true_peak_max_ =
+		std::max(voice_true_peak_max_, voice_true_peak_.process(frame.samples, frame.frame_count));
+
+	// The whole voice stream goes onto the mix timeline; the gate marks where the mix is measured
+	const uint64_t position = timeline_.place(mix_bus_.next_position(kMixVoice), frame.timestamp, timeline_now());
+
+	// The VAD decides every 10 ms hop; each run of samples it returns is measured in one state
+	const size_t stride = frame.frame_count;
+	for (uint32_t done = 0; done < frame.frame_count;) {
+		const bool voice_active = vad_.is_active();
+		const float *samples = frame.samples + done;
+		const uint32_t run = vad_.update(frame, done);
+		const uint64_t run_position = position + done;
+		done += run;
+
+		mix_bus_.accumulate(kMixVoice, run_position, samples, run, voice_active, stride);
+		if (!voice_active) {
+			voice_preroll_.push(run_position, samples, run, stride);
+			if (derived_mix_) {
+				// Left silent unless an onset is replayed there; keeps the weighted timeline moving
+				weighted_mix_bus_.skip(kMixVoice, run_position, run);
+			}
+			if (vad_.is_active()) {
+				replay_voice_onset();
+			}
+			continue;
+		}
+
+		if (derived_mix_) {
+			queue_weighted(kMixVoice, run_position, run);
+		}
+		// Queued first: a full stage flushes inside push()
+		kweighting_.push(lane(kStreamVoice), samples, run, stride);
+		voice_dirty_ = true;
+		voice_released_ = !vad_.is_active();
+	}
+	results_.voice_active.store(vad_.is_active(), std::memory_order_relaxed);
+}
+
+void LoudnessAnalyzer::replay_voice_onset()
+{
+	if (voice_released_) {
+		// First speech after a release: start the short-term windows afresh. Deferred to here so the
+		// samples before the release, which the mix buses may not have read yet, are still measured and the
+		// published values hold through the pause. Every piece is fixed-size state cleared in place, so this
+		// never allocates.
+		kweighting_.flush();
+		kweighting_.reset_lane(lane(kStreamVoice));
+		kweighting_.reset_lane(lane(kStreamMix));
+		voice_meter_.reset();
+		mix_meter_.reset();
+		voice_released_ = false;
+	}
+
+	// The onset is still inside the mix buses' hold, so gating it now measures it as part of the mix
+	PrerollRing::Piece pieces[2];
+	const size_t count = voice_preroll_.latest(vad_.onset_samples(), pieces);
+	for (size_t i = 0; i < count; ++i) {
+		const PrerollRing::Piece &piece = pieces[i];
+		if (derived_mix_) {
+			queue_weighted(kMixVoice, piece.position, piece.frames);
+		} else {
+			mix_bus_.set_gate(piece.position, piece.position + piece.frames);
+		}
+		// Queued first: a full stage flushes inside push()
+		kweighting_.push(lane(kStreamVoice), piece.samples, piece.frames, voice_preroll_.stride());
+		voice_dirty_ = true;
+	}
+	voice_preroll_.clear();
+}
+
+void LoudnessAnalyzer::process_bgm(int input, const AudioFrame &frame)
+{
+	BgmInput &slot = bgm_inputs_[input];
+	kweighting_.push(lane(kStreamSources + input), frame.samples, frame.frame_count);
+	slot.true_peak_max = std::max(slot.true_peak_max, slot.true_peak.process(frame.samples, frame.frame_count));
+	slot.dirty = true;
+	bgm_dirty_ = true;
+
+	const uint64_t position = timeline_.place(bgm_bus_.next_position(input), frame.timestamp, timeline_now());
+	bgm_bus_.accumulate(input, position, frame.samples, frame.frame_count);
+}
+
+void LoudnessAnalyzer::process_track(int track, const AudioFrame &frame)
+{
+	TrackInput &slot = track_inputs_[track];
+	kweighting_.push(lane(kStreamTracks + track), frame.samples, frame.frame_count);
+	slot.true_peak_max = std::max(slot.true_peak_max, slot.true_peak.process(frame.samples, frame.frame_count));
+	slot.dirty = true;
+}
+
+void LoudnessAnalyzer::process_bgm_bus()
+{
+	for (;;) {
+		const uint64_t position = bgm_bus_.read_position();
+		const size_t frames = bgm_bus_.read(bgm_block_.data(), nullptr, AudioFrame::kMaxSamples);
+		if (frames == 0) {
+			break;
+		}
+
+		// The planes are packed, so the peak of all channels is one pass
+		bgm_peak_.store(kernels::peak_abs(bgm_block_.data(), static_cast<uint32_t>(frames * channels_)),
+				std::memory_order_relaxed);
+		bgm_true_peak_max_ = std::max(bgm_true_peak_max_, bgm_true_peak_.process(bgm_block_.data(), frames));
+
+		if (!mix_bus_.has_input(kMixBgm)) {
+			mix_bus_.add_input(kMixBgm, position);
+		}
+		mix_bus_.accumulate(kMixBgm, position, bgm_block_.data(), static_cast<uint32_t>(frames));
+
+		if (derived_mix_) {
+			queue_weighted(kMixBgm, position, frames);
+		}
+		kweighting_.push(lane(kStreamBgm), bgm_block_.data(), frames);
+		bgm_dirty_ = true;
+	}
+
+	// With no source selected the mix is the voice alone; don't wait for BGM
+	if (!bgm_bus_.has_inputs()) {
+		mix_bus_.remove_input(kMixBgm);
+	}
+}
+
+void LoudnessAnalyzer::process_mix_bus()
+{
+	for (;;) {
+		const size_t frames = mix_bus_.read(mix_block_.data(), mix_gate_.data(), AudioFrame::kMaxSamples);
+		if (frames == 0) {
+			break;
+		}
+
+		// Measure the runs where the voice was active; the true-peak filter sees every run to stay continuous
+		double peak = 0.0;
+		bool gated = false;
+		size_t i = 0;
+		while (i < frames) {
+			size_t end = i;
+			while (end < frames && mix_gate_[end] == mix_gate_[i]) {
+				++end;
+			}
+
+			const uint32_t run = static_cast<uint32_t>(end - i);
+			const float true_peak = mix_true_peak_.process(mix_block_.data() + i, run, frames);
+			if (mix_gate_[i]) {
+				for (uint32_t c = 0; c < channels_; ++c) {
+					const float *plane = mix_block_.data() + c * frames;
+					peak = std::max(peak, kernels::peak_abs(plane + i, run));
+				}
+				mix_true_peak_max_ = std::max(mix_true_peak_max_, true_peak);
+				if (!derived_mix_) {
+					kweighting_.push(lane(kStreamMix), mix_block_.data() + i, run, frames);
+				}
+				gated = true;
+			}
+			i = end;
+		}
+
+		if (gated) {
+			mix_peak_.store(peak, std::memory_order_relaxed);
+			mix_dirty_ = true;
+		}
+	}
+}
+
+void LoudnessAnalyzer::queue_weighted(int input, uint64_t position, size_t frames)
+{
+	WeightedQueue &queue = weighted_queues_[input];
+	if (queue.count == WeightedQueue::kCapacity) {
+		kweighting_.flush(); // Places and pops every queued block
+	}
+	queue.blocks[(queue.head + queue.count) % WeightedQueue::kCapacity] = WeightedBlock{position, frames};
+	++queue.count;
+}
+
+void LoudnessAnalyzer::on_weighted(size_t first_lane, const float *weighted, size_t stride, size_t frames)
+{
+	const int input = (first_lane == lane(kStreamVoice)) ? kMixVoice : kMixBgm;
+	WeightedQueue &queue = weighted_queues_[input];
+
+	// The bank returns each lane's samples in push order
+	while (frames > 0 && queue.count > 0) {
+		const WeightedBlock &block = queue.blocks[queue.head];
+		const size_t chunk = std::min(frames, block.frames - queue.done);
+		const uint64_t position = block.position + queue.done;
+
+		if (!weighted_mix_bus_.has_input(input)) {
+			weighted_mix_bus_.add_input(input, position);
+		}
+		weighted_mix_bus_.accumulate(input, position, weighted, static_cast<uint32_t>(chunk),
+					     input == kMixVoice, stride);
+
+		weighted += chunk;
+		frames -= chunk;
+		queue.done += chunk;
+		if (queue.done == block.frames) {
+			queue.head = (queue.head + 1) % WeightedQueue::kCapacity;
+			--queue.count;
+			queue.done = 0;
+		}
+	}
+}
+
+void LoudnessAnalyzer::process_weighted_mix_bus()
+{
+	// Follow mix_bus_ once the last BGM block has been placed
+	if (!mix_bus_.has_input(kMixBgm)) {
+		weighted_mix_bus_.remove_input(kMixBgm);
+	}
+
+	for (;;) {
+		const size_t frames =
+			weighted_mix_bus_.read(mix_block_.data(), mix_gate_.data(), AudioFrame::kMaxSamples);
+		if (frames == 0) {
+			break;
+		}
+
+		size_t i = 0;
+		while (i < frames) {
+			if (!mix_gate_[i]) {
+				++i;
+				continue;
+			}
+			size_t end = i;
+			while (end < frames && mix_gate_[end]) {
+				++end;
+			}
+			mix_meter_.add_weighted(mix_block_.data() + i, end - i, frames, channels_);
+			i = end;
+		}
+	}
+}
+
+uint64_t LoudnessAnalyzer::timeline_now() const
+{
+	return std::max(bgm_bus_.leader(), mix_bus_.leader());
+}
+
+void LoudnessAnalyzer::join_bgm_input(int input)
+{
+	BgmInput &slot = bgm_inputs_[input];
+	leave_bgm_input(input);
+
+	slot.loudness.set_sample_rate(meter_rate_);
+	slot.true_peak.reset();
+	slot.peak.store(0.0, std::memory_order_relaxed);
+	bgm_bus_.add_input(input, timeline_now());
+	slot.joined = true;
+}
+
+void LoudnessAnalyzer::leave_bgm_input(int input)
+{
+	BgmInput &slot = bgm_inputs_[input];
+	bgm_bus_.remove_input(input);
+	kweighting_.reset_lane(lane(kStreamSources + input));
+	slot.joined = false;
+	slot.dirty = false;
+	results_.bgm_sources[input].reset();
+}
+
+void LoudnessAnalyzer::join_track_input(int track)
+{
+	TrackInput &slot = track_inputs_[track];
+	leave_track_input(track);
+
+	slot.loudness.set_sample_rate(meter_rate_);
+	slot.programme.reset();
+	slot.loudness.set_programme(&slot.programme);
+	slot.true_peak.reset();
+	slot.peak.store(0.0, std::memory_order_relaxed);
+	kweighting_.bind(lane(kStreamTracks + track), &slot.loudness, channel_weights_, channels_);
+	slot.joined = true;
+}
+
+void LoudnessAnalyzer::leave_track_input(int track)
+{
+	TrackInput &slot = track_inputs_[track];
+
+	// Unbound lanes drop out of the filter passes
+	kweighting_.bind(lane(kStreamTracks + track), nullptr, nullptr, channels_);
+	slot.joined = false;
+	slot.dirty = false;
+	results_.tracks[track].reset();
+}
+
+void LoudnessAnalyzer::update_voice_metrics()
+{
+	results_.voice_lufs.store(window_loudness(voice_meter_), std::memory_order_relaxed);
+	results_.voice_integrated_lufs.store(voice_programme_.integrated(), std::memory_order_relaxed);
+	results_.voice_lra.store(voice_programme_.range(), std::memory_order_relaxed);
+
+	// Peak in dBFS
+	double peak = voice_peak_.load(std::memory_order_relaxed);
+	double peak_dbfs = (peak > 0.0) ? 20.0 * std::log10(peak) : -HUGE_VAL;
+	results_.voice_peak_dbfs.store(peak_dbfs, std::memory_order_relaxed);
+	results_.voice_true_peak_dbtp.store(TruePeakDetector::to_dbtp(voice_true_peak_max_), std::memory_order_relaxed);
+}
+
+void LoudnessAnalyzer::update_bgm_metrics()
+{
+	results_.bgm_lufs.store(window_loudness(bgm_meter_), std::memory_order_relaxed);
+	results_.bgm_integrated_lufs.store(bgm_programme_.integrated(), std::memory_order_relaxed);
+	results_.bgm_lra.store(bgm_programme_.range(), std::memory_order_relaxed);
+
+	// Peak in dBFS
+	double peak = bgm_peak_.load(std::memory_order_relaxed);
+	double peak_dbfs = (peak > 0.0) ? 20.0 * std::log10(peak) : -HUGE_VAL;
+	results_.bgm_peak_dbfs.store(peak_dbfs, std::memory_order_relaxed);
+	results_.bgm_true_peak_dbtp.store(TruePeakDetector::to_dbtp(bgm_true_peak_max_), std::memory_order_relaxed);
+
+	// Individual sources
+	for (int n = 0; n < kMaxBgmInputs; ++n) {
+		BgmInput &slot = bgm_inputs_[n];
+		if (!slot.dirty) {
+			continue;
+		}
+		slot.dirty = false;
+
+		BgmSourceResults &source = results_.bgm_sources[n];
+		source.lufs.store(window_loudness(slot.loudness), std::memory_order_relaxed);
+		peak = slot.peak.load(std::memory_order_relaxed);
+		source.peak_dbfs.store((peak > 0.0) ? 20.0 * std::log10(peak) : -HUGE_VAL, std::memory_order_relaxed);
+		source.true_peak_dbtp.store(TruePeakDetector::to_dbtp(slot.true_peak_max), std::memory_order_relaxed);
+	}
+}
+
+void LoudnessAnalyzer::update_mix_metrics()
+{
+	results_.mix_lufs.store(window_loudness(mix_meter_), std::memory_order_relaxed);
+	results_.mix_integrated_lufs.store(mix_programme_.integrated(), std::memory_order_relaxed);
+	results_.mix_lra.store(mix_programme_.range(), std::memory_order_relaxed);
+
+	// Peak in dBFS
+	double peak = mix_peak_.load(std::memory_order_relaxed);
+	double peak_dbfs = (peak > 0.0) ? 20.0 * std::log10(peak) : -HUGE_VAL;
+	results_.mix_peak_dbfs.store(peak_dbfs, std::memory_order_relaxed);
+	results_.mix_true_peak_dbtp.store(TruePeakDetector::to_dbtp(mix_true_peak_max_), std::memory_order_relaxed);
+}
+
+void LoudnessAnalyzer::update_track_metrics()
+{
+	for (int n = 0; n < kMaxTrackInputs; ++n) {
+		TrackInput &slot = track_inputs_[n];
+		if (!slot.dirty) {
+			continue;
+		}
+		slot.dirty = false;
+
+		TrackResults &track = results_.tracks[n];
+		track.lufs.store(window_loudness(slot.loudness), std::memory_order_relaxed);
+		track.integrated_lufs.store(slot.programme.integrated(), std::memory_order_relaxed);
+		track.lra.store(slot.programme.range(), std::memory_order_relaxed);
+
+		const double peak = slot.peak.load(std::memory_order_relaxed);
+		track.peak_dbfs.store((peak > 0.0) ? 20.0 * std::log10(peak) : -HUGE_VAL, std::memory_order_relaxed);
+		const double true_peak = TruePeakDetector::to_dbtp(slot.true_peak_max);
+		track.true_peak_dbtp.store(true_peak, std::memory_order_relaxed);
+		track.clip_status.store(clip_status_of(true_peak), std::memory_order_relaxed);
+	}
+}
+
+double LoudnessAnalyzer::window_loudness(const LoudnessMeter &meter) const
+{
+	return window_ == LoudnessWindow::Momentary ? meter.momentary() : meter.shortterm();
+}
+
+void LoudnessAnalyzer::update_balance_judgment()
+{
+	double voice = results_.voice_lufs.load(std::memory_order_relaxed);
+	double bgm = results_.bgm_lufs.load(std::memory_order_relaxed);
+
+	if (voice == -HUGE_VAL || bgm == -HUGE_VAL) {
+		return; // Keep previous state
+	}
+
+	double delta = voice - bgm;
+	results_.balance_delta.store(delta, std::memory_order_relaxed);
+
+	double target = config_.balance_target.load(std::memory_order_relaxed);
+	double hyst = config_.hysteresis.load(std::memory_order_relaxed);
+
+	auto current = results_.balance_status.load(std::memory_order_relaxed);
+	Status new_status = current;
+
+	// OK: delta >= target
+	// WARN: target-3 <= delta < target
+	// BAD: delta < target-3
+	double ok_thresh = target;
+	double warn_thresh = target - 3.0;
+
+	if (delta >= ok_thresh + hyst) {
+		new_status = Status::OK;
+	} else if (delta < warn_thresh - hyst) {
+		new_status = Status::BAD;
+	} else if (delta < ok_thresh - hyst && delta >= warn_thresh + hyst) {
+		new_status = Status::WARN;
+	}
+	// Otherwise keep current state (hysteresis zone)
+
+	results_.balance_status.store(new_status, std::memory_order_relaxed);
+}
+
+void LoudnessAnalyzer::update_mix_judgment()
+{
+	double mix = results_.mix_lufs.load(std::memory_order_relaxed);
+
+	if (mix == -HUGE_VAL) {
+		return;
+	}
+
+	double ok_thresh = config_.mix_ok_threshold.load(std::memory_order_relaxed);
+	double warn_thresh = config_.mix_warn_threshold.load(std::memory_order_relaxed);
+	double hyst = config_.hysteresis.load(std::memory_order_relaxed);
+
+	auto current = results_.mix_status.load(std::memory_order_relaxed);
+	Status new_status = current;
+
+	if (mix >= ok_thresh + hyst) {
+		new_status = Status::OK;
+	} else if (mix < warn_thresh - hyst) {
+		new_status = Status::BAD;
+	} else if (mix < ok_thresh - hyst && mix >= warn_thresh + hyst) {
+		new_status = Status::WARN;
+	}
+
+	results_.mix_status.store(new_status, std::memory_order_relaxed);
+}
+
+void LoudnessAnalyzer::update_clip_judgment()
+{
+	// True peaks catch the inter-sample overs a resampler or lossy encoder would clip
+	double voice_peak = results_.voice_true_peak_dbtp.load(std::memory_order_relaxed);
+	double bgm_peak = results_.bgm_true_peak_dbtp.load(std::memory_order_relaxed);
+	double mix_peak = results_.mix_true_peak_dbtp.load(std::memory_order_relaxed);
+
+	double max_peak = std::max({voice_peak, bgm_peak, mix_peak});
+	results_.clip_status.store(clip_status_of(max_peak), std::memory_order_relaxed);
+}
+
+void LoudnessAnalyzer::init_loudness_meters(uint32_t sample_rate)
+{
+	meter_rate_ = sample_rate;
+	voice_meter_.set_sample_rate(sample_rate);
+	bgm_meter_.set_sample_rate(sample_rate);
+	mix_meter_.set_sample_rate(sample_rate);
+	voice_programme_.reset();
+	bgm_programme_.reset();
+	mix_programme_.reset();
+	voice_meter_.set_programme(&voice_programme_);
+	bgm_meter_.set_programme(&bgm_programme_);
+	mix_meter_.set_programme(&mix_programme_);
+	kweighting_.set_sample_rate(sample_rate);
+	voice_true_peak_.reset();
+	bgm_true_peak_.reset();
+	mix_true_peak_.reset();
+
+	// The derived mix takes the voice and BGM lane outputs instead of filtering the mix itself
+	const bool was_derived = derived_mix_;
+	derived_mix_ = mix_mode_.load(std::memory_order_relaxed) == MixMode::Derived;
+	if (derived_mix_ && !was_derived) {
+		// weighted_mix_bus_ sat idle while mix_bus_ kept going; restart it where mix_bus_ reads next
+		weighted_mix_bus_.remove_input(kMixVoice);
+		weighted_mix_bus_.remove_input(kMixBgm);
+		weighted_mix_bus_.add_input(kMixVoice, mix_bus_.read_position());
+	}
+
+	// One group of channels_ lanes per stream, weighted per channel
+	kweighting_.unbind_all();
+	kweighting_.bind(lane(kStreamVoice), &voice_meter_, channel_weights_, channels_);
+	kweighting_.bind(lane(kStreamBgm), &bgm_meter_, channel_weights_, channels_);
+	kweighting_.bind(lane(kStreamMix), derived_mix_ ? nullptr : &mix_meter_, channel_weights_, channels_);
+	for (int n = 0; n < kMaxBgmInputs; ++n) {
+		kweighting_.bind(lane(kStreamSources + n), &bgm_inputs_[n].loudness, channel_weights_, channels_);
+	}
+	kweighting_.set_tap(lane(kStreamVoice), derived_mix_ ? this : nullptr);
+	kweighting_.set_tap(lane(kStreamBgm), derived_mix_ ? this : nullptr);
+	weighted_queues_[kMixVoice] = WeightedQueue{};
+	weighted_queues_[kMixBgm] = WeightedQueue{};
+	for (int n = 0; n < kMaxBgmInputs; ++n) {
+		leave_bgm_input(n);
+	}
+	for (int n = 0; n < kMaxTrackInputs; ++n) {
+		leave_track_input(n); // Rebound by join_track_input on the next batch
+	}
+}
+
+void LoudnessAnalyzer::reset_meters(Stream stream)
+{
+	// Nothing is staged between batches, so only the filter state of the lanes is dropped
+	if (stream == Stream::Voice || stream == Stream::All) {
+		kweighting_.reset_lane(lane(kStreamVoice));
+		voice_meter_.reset();
+		voice_programme_.reset();
+		results_.voice_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		results_.voice_integrated_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		results_.voice_lra.store(0.0, std::memory_order_relaxed);
+	}
+	if (stream == Stream::Bgm || stream == Stream::All) {
+		kweighting_.reset_lane(lane(kStreamBgm));
+		bgm_meter_.reset();
+		bgm_programme_.reset();
+		results_.bgm_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		results_.bgm_integrated_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		results_.bgm_lra.store(0.0, std::memory_order_relaxed);
+		for (int n = 0; n < kMaxBgmInputs; ++n) {
+			kweighting_.reset_lane(lane(kStreamSources + n));
+			bgm_inputs_[n].loudness.reset();
+			results_.bgm_sources[n].lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		}
+	}
+	if (stream == Stream::Mix || stream == Stream::All) {
+		kweighting_.reset_lane(lane(kStreamMix));
+		mix_meter_.reset();
+		mix_programme_.reset();
+		results_.mix_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		results_.mix_integrated_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+		results_.mix_lra.store(0.0, std::memory_order_relaxed);
+	}
+	if (stream == Stream::All) {
+		for (int n = 0; n < kMaxTrackInputs; ++n) {
+			TrackInput &slot = track_inputs_[n];
+			kweighting_.reset_lane(lane(kStreamTracks + n));
+			slot.loudness.reset();
+			slot.programme.reset();
+			results_.tracks[n].lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+			results_.tracks[n].integrated_lufs.store(-HUGE_VAL, std::memory_order_relaxed);
+			results_.tracks[n].lra.store(0.0, std::memory_order_relaxed);
+		}
+	}
+}
+
+} // namespace lbm
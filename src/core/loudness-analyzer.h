@@ -0,0 +1,447 @@
+#pragma once
+
+#include "analysis-results.h"
+#include "audio-frame.h"
+#include "channel-layout.h"
+#include "k-weighting.h"
+#include "loudness-meter.h"
+#include "preroll-ring.h"
+#include "sample-ring.h"
+#include "spsc-queue.h"
+#include "stream-telemetry.h"
+#include "summing-bus.h"
+#include "timeline-clock.h"
+#include "true-peak.h"
+#include "vad.h"
+#include "wakeup-event.h"
+#include "warmup-window.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace lbm {
+
+class LoudnessAnalyzer : private KWeightingTap {
+public:
+	// queue_seconds: how much audio each input queue can buffer before frames are dropped
+	explicit LoudnessAnalyzer(double queue_seconds = kDefaultQueueSeconds);
+	~LoudnessAnalyzer();
+
+	// Non-copyable
+	LoudnessAnalyzer(const LoudnessAnalyzer &) = delete;
+	LoudnessAnalyzer &operator=(const LoudnessAnalyzer &) = delete;
+
+	// Start/stop worker thread
+	void start();
+	void stop();
+	bool is_running() const { return running_.load(std::memory_order_relaxed); }
+
+	// BGM inputs: each BGM source gets its own single-producer queue
+	// Returns the input index, or -1 if all kMaxBgmInputs inputs are in use
+	int add_bgm_input();
+
+	// Retire an input; its producer must already be detached. Queued frames are discarded.
+	void remove_bgm_input(int input);
+
+	// Push audio frames from audio callback (producer side)
+	// `samples` holds channels() planes of `frames` samples back to back
+	// Voice must be pushed from one thread; each BGM input from one thread (its source's callback)
+	// Returns false if the frame was rejected (invalid size, unknown input or queue full)
+	bool push_voice_frame(const float *samples, uint32_t frames);
+	bool push_bgm_frame(int input, const float *samples, uint32_t frames);
+
+	// Zero-copy producer API (same threading rules as push_*)
+	// Reserve space for up to `frames` frames of channels() planes, write them in place (kernels::capture_planes,
+	// plane c at c * frames), then commit the same frame count with the stats measured while writing them.
+	// Returns nullptr if the queue is full. A failed reservation is counted as DropReason::QueueFull.
+	// timestamp: OBS audio timestamp in ns with the source's sync offset applied (0 = continue the stream)
+	// Voice: pass next_voice_hops() to the capture kernel so it splits the energy where the VAD's hops end, then
+	// commit the filled HopEnergy with the block
+	float *reserve_voice_frame(uint32_t frames);
+	float *reserve_bgm_frame(int input, uint32_t frames);
+	HopEnergy next_voice_hops() const;
+	void commit_voice_frame(uint32_t frames, const BlockStats &stats, uint64_t timestamp = 0,
+				const HopEnergy *hops = nullptr);
+	void commit_bgm_frame(int input, uint32_t frames, const BlockStats &stats, uint64_t timestamp = 0);
+
+	// Count a block the caller filtered out before pushing (muted, oversized)
+	void count_voice_drop(DropReason reason, uint32_t frames) { voice_counters_.count_drop(reason, frames); }
+	void count_bgm_drop(int input, DropReason reason, uint32_t frames);
+
+	// Output tracks: OBS mixer tracks as the outputs receive them (track 0 = track 1), each with its own
+	// single-producer queue. A track is measured on its own, without the VAD gate or the timeline: loudness in
+	// the current window, integrated loudness and LRA since it was added, peaks and a clip judgment, published in
+	// results().tracks. Its K-weighting lanes are filtered only while it is added.
+	// Returns false if `track` is out of range or already added
+	bool add_track_input(int track);
+
+	// Retire a track; its producer must already be detached. Queued frames are discarded.
+	void remove_track_input(int track);
+
+	// Producer side of a track (same threading rules as a BGM input; no timestamp, tracks are not aligned)
+	bool push_track_frame(int track, const float *samples, uint32_t frames);
+	float *reserve_track_frame(int track, uint32_t frames);
+	void commit_track_frame(int track, uint32_t frames, const BlockStats &stats);
+	void count_track_drop(int track, DropReason reason, uint32_t frames);
+
+	// Pipeline telemetry (any thread)
+	// BGM / track counters restart when an input is reassigned by add_bgm_input() / add_track_input()
+	StreamTelemetry voice_telemetry() const { return voice_counters_.snapshot(); }
+	StreamTelemetry bgm_telemetry(int input) const;
+	StreamTelemetry track_telemetry(int track) const;
+
+	// Offline mode: initialize states without spawning the worker thread.
+	// Frames pushed afterwards are processed on the calling thread by process_pending().
+	void start_offline();
+
+	// Drain all queued frames on the calling thread (offline mode only, no 1 ms polling)
+	// Returns the number of frames processed
+	size_t process_pending();
+
+	// Number of frames processed by the worker thread so far (voice + BGM + tracks)
+	uint64_t processed_frames() const { return processed_frames_.load(std::memory_order_acquire); }
+
+	// Get analysis results (consumer side, UI thread)
+	const AnalysisResults &results() const { return results_; }
+	AnalysisResults &results() { return results_; }
+
+	// Get/set configuration
+	const AnalysisConfig &config() const { return config_; }
+	AnalysisConfig &config() { return config_; }
+
+	// Control calls (set_sample_rate, set_loudness_window, reset_stream, reset_states, warm_voice,
+	// warm_bgm_input) come from one thread at a time (the UI thread). While the worker runs they are queued to it
+	// lock-free and applied between batches, so every block is measured entirely before or entirely after a
+	// change and the thread keeps running.
+	// Stopped or offline, they are applied on the calling thread.
+
+	// Set sample rate (called when OBS audio config changes)
+	// Queues are resized only while stopped (a running analyzer keeps their size, which only sets the latency
+	// budget); the meters, filters and timeline follow the new rate either way
+	void set_sample_rate(uint32_t sample_rate);
+	uint32_t sample_rate() const { return sample_rate_.load(std::memory_order_relaxed); }
+
+	// Speaker layout the inputs arrive in (OBS's output layout); every stream is measured per channel with the
+	// BS.1770 channel weights. Ignored while running, so call this before registering capture callbacks.
+	void set_channel_layout(ChannelLayout layout);
+	ChannelLayout channel_layout() const { return layout_.load(std::memory_order_relaxed); }
+	uint32_t channels() const { return channel_count(channel_layout()); }
+
+	// How the mix loudness is measured
+	//   Derived:  sum of the K-weighted voice and BGM, sample by sample (K-weighting is linear, so the mix
+	//             needs no filter pass of its own)
+	//   Filtered: the summed mix through its own K-weighting filter
+	enum class MixMode : uint8_t { Derived, Filtered };
+
+	// Takes effect at the next start() / start_offline()
+	void set_mix_mode(MixMode mode) { mix_mode_.store(mode, std::memory_order_relaxed); }
+	MixMode mix_mode() const { return mix_mode_.load(std::memory_order_relaxed); }
+
+	// Window the published *_lufs values and the judgments use (default short-term, 3 s)
+	enum class LoudnessWindow : uint8_t { Momentary, Shortterm };
+	void set_loudness_window(LoudnessWindow window);
+	LoudnessWindow loudness_window() const { return loudness_window_.load(std::memory_order_relaxed); }
+
+	// Restart the loudness of one stream (short-term window, integrated loudness and LRA, and for BGM every
+	// source; All also restarts the output tracks) and clear its published values
+	enum class Stream : uint8_t { Voice, Bgm, Mix, All };
+	void reset_stream(Stream stream);
+
+	// Reset all LUFS states
+	void reset_states() { reset_stream(Stream::All); }
+
+	// Start the short-term window of the voice / of BGM input `input` from the history a source built up while
+	// it was not selected, instead of from silence (ignored if `window` ran at another rate or layout)
+	// The voice takes the newest sub-blocks at or above the VAD threshold, as if the VAD had gated them; the BGM
+	// sum adds the source's energy to what it already holds. Integrated loudness and LRA are not affected.
+	// Call warm_voice() between detaching the old voice producer and attaching the new one: the voice still
+	// queued from the old source is dropped, so it is not measured on top of the new source's window.
+	void warm_voice(const WarmupWindow &window);
+	void warm_bgm_input(int input, const WarmupWindow &window);
+
+	// Default input buffering per queue
+	static constexpr double kDefaultQueueSeconds = 2.0;
+
+	// Maximum number of simultaneously selected BGM sources
+	static constexpr int kMaxBgmInputs = kMaxBgmSources;
+	static_assert(kMaxBgmInputs <= SummingBus::kMaxInputs, "BGM bus too narrow");
+
+	// Output tracks (OBS has six mixer tracks)
+	static constexpr int kMaxTrackInputs = kMaxOutputTracks;
+
+	// Streams further behind the leading one than this are summed as silence
+	static constexpr double kMaxSkewSeconds = 0.2;
+
+	// Voice kept from before each VAD activation, replayed into the voice and mix measurement; the mix buses
+	// hold this much back so the onset can still be gated (must cover the VAD attack time)
+	static constexpr double kPrerollSeconds = 0.2;
+
+private:
+	// Size the input queues for queue_seconds_ at the current sample rate, then configure_buses()
+	void allocate_queues();
+
+	// Size the buses and restart the timeline at `sample_rate` (consumer side)
+	void configure_buses(uint32_t sample_rate);
+
+	// Control commands, applied by the consumer between batches
+	struct Command {
+		enum class Type : uint8_t { SetSampleRate, SetWindow, ResetStream, WarmVoice, WarmBgm };
+		Type type;
+		uint32_t value; // Sample rate, LoudnessWindow, Stream or BGM input
+
+		// WarmVoice / WarmBgm: sub-block energies to start the window with, oldest first
+		uint32_t blocks{0};
+		double energies[LoudnessMeter::kShorttermBlocks]{};
+
+		// WarmVoice: voice samples committed before the switch (dropped unmeasured)
+		uint64_t position{0};
+	};
+
+	// Queue a command to the worker, or apply it here when there is none (control side)
+	void send_command(const Command &command);
+
+	// Apply every queued command (consumer side)
+	void apply_commands();
+	void apply_command(const Command &command);
+
+	// Published loudness of `meter` in the current window
+	double window_loudness(const LoudnessMeter &meter) const;
+
+	void worker_loop();
+
+	// True if any queue has frames or an input or track is waiting to be retired (consumer side)
+	bool has_pending_work() const;
+
+	// Process every queued voice, BGM and track frame, then publish metrics and judgments once
+	// Returns false if both queues were empty
+	bool process_batch();
+
+	// Process voice audio
+	void process_voice(const AudioFrame &frame);
+
+	// The VAD just fired: measure the onset kept in voice_preroll_ as voice and, through the mix gate, as mix
+	void replay_voice_onset();
+
+	// Process one BGM source block (per-source loudness + summing bus)
+	void process_bgm(int input, const AudioFrame &frame);
+
+	// Process one output track block (loudness and true peak only)
+	void process_track(int track, const AudioFrame &frame);
+
+	// Feed the summed BGM released by the bus to the BGM state and the mix timeline
+	void process_bgm_bus();
+
+	// Measure the voice + BGM mix released by the mix timeline
+	void process_mix_bus();
+
+	// Derived mix: queue a voice / BGM block until the bank returns it K-weighted
+	void queue_weighted(int input, uint64_t position, size_t frames);
+
+	// Derived mix: place K-weighted voice / BGM samples on weighted_mix_bus_ (KWeightingTap)
+	void on_weighted(size_t lane, const float *weighted, size_t stride, size_t frames) override;
+
+	// Derived mix: measure the K-weighted mix released by weighted_mix_bus_
+	void process_weighted_mix_bus();
+
+	// Leading position of the shared sample timeline
+	uint64_t timeline_now() const;
+
+	// Update metrics from the loudness meters
+	void update_voice_metrics();
+	void update_bgm_metrics();
+	void update_mix_metrics();
+	void update_track_metrics();
+
+	// Update judgments based on current metrics
+	void update_balance_judgment();
+	void update_mix_judgment();
+	void update_clip_judgment();
+
+	// Clear all loudness meters at `sample_rate` and bind them to their K-weighting lanes
+	void init_loudness_meters(uint32_t sample_rate);
+
+	// Clear the meters and K-weighting lanes of `stream` and its published values (consumer side)
+	void reset_meters(Stream stream);
+
+	// Worker thread
+	std::thread worker_thread_;
+	std::atomic<bool> running_{false};
+
+	// Worker wakeup: producers signal only on the empty -> non-empty transition
+	WakeupEvent wakeup_;
+	uint32_t spin_limit_{kMinSpin};
+	static constexpr uint32_t kMinSpin = 4;
+	static constexpr uint32_t kMaxSpin = 64;
+	// Safety net only; every producer path signals the worker
+	static constexpr int kWakeupTimeoutMs = 100;
+
+	// Control commands from the control thread (lock-free, one producer)
+	static constexpr size_t kCommandCapacity = 32;
+	SPSCQueue<Command, kCommandCapacity> commands_;
+
+	// Audio queues (lock-free, sized by time)
+	SampleRing voice_queue_;
+	StreamCounters voice_counters_;
+	uint32_t voice_hop_phase_{0}; // Voice frames committed since the last VAD hop end (producer side)
+	double queue_seconds_;
+	size_t queue_samples_{0};
+	size_t queue_headers_{0};
+
+	// BGM input slots
+	// Free -> Active by add_bgm_input (UI thread), Active -> Retiring by remove_bgm_input (UI thread),
+	// Retiring -> Free by the consumer once the queue is drained, so a slot is never reused while read.
+	enum class InputState : uint8_t { Free, Active, Retiring };
+	struct BgmInput {
+		SampleRing queue;
+		StreamCounters counters;
+		std::atomic<InputState> state{InputState::Free};
+		std::atomic<double> peak{0.0}; // Last block peak (producer side)
+
+		// Consumer side: per-source loudness, true peak and bus membership
+		LoudnessMeter loudness;
+		TruePeakDetector true_peak;
+		float true_peak_max{0.0f}; // Over the current batch
+		bool joined{false};
+		bool dirty{false};
+	};
+	BgmInput bgm_inputs_[kMaxBgmInputs];
+
+	// Discard Retiring inputs and mark them Free (consumer side)
+	void retire_bgm_inputs();
+
+	// Attach an Active input to the bus with a fresh loudness meter / detach it (consumer side)
+	void join_bgm_input(int input);
+	void leave_bgm_input(int input);
+
+	// Output track slots, indexed by track; same life cycle as the BGM inputs
+	struct TrackInput {
+		SampleRing queue;
+		StreamCounters counters;
+		std::atomic<InputState> state{InputState::Free};
+		std::atomic<double> peak{0.0}; // Last block peak (producer side)
+
+		// Consumer side: the whole track's loudness, programme and true peak
+		LoudnessMeter loudness;
+		ProgrammeLoudness programme;
+		TruePeakDetector true_peak;
+		float true_peak_max{0.0f}; // Over the current batch
+		bool joined{false};
+		bool dirty{false};
+	};
+	TrackInput track_inputs_[kMaxTrackInputs];
+
+	// Discard Retiring tracks and mark them Free (consumer side)
+	void retire_track_inputs();
+
+	// Bind an Active track's lanes with a fresh meter and programme / unbind them (consumer side)
+	void join_track_input(int track);
+	void leave_track_input(int track);
+
+	// Consumer-side timeline (sized by allocate_queues)
+	// bgm_bus_ sums the BGM inputs; mix_bus_ sums the voice and that BGM sum at the same timeline positions
+	TimelineClock timeline_;
+	SummingBus bgm_bus_;
+	SummingBus mix_bus_;
+	static constexpr int kMixVoice = 0;
+	static constexpr int kMixBgm = 1;
+
+	// Derived mix: weighted_mix_bus_ carries the K-weighted voice and BGM at the positions used on mix_bus_
+	// (mix_bus_ still gives the mix peak and the voice gate). Filtered blocks only come back on a flush, so
+	// each queue remembers where its pending blocks go, in push order.
+	struct WeightedBlock {
+		uint64_t position;
+		size_t frames;
+	};
+	struct WeightedQueue {
+		static constexpr size_t kCapacity = 16;
+		WeightedBlock blocks[kCapacity];
+		size_t head{0};
+		size_t count{0};
+		size_t done{0}; // Frames of blocks[head] already placed
+	};
+	std::atomic<MixMode> mix_mode_{MixMode::Derived};
+	bool derived_mix_{true}; // mix_mode_ as of the last init_loudness_meters()
+	SummingBus weighted_mix_bus_;
+	WeightedQueue weighted_queues_[2]; // By mix input
+
+	// Smallest block the header rings are sized for (OBS ticks are 1024 frames)
+	static constexpr size_t kMinQueueBlock = 64;
+
+	// Maximum frames taken from each queue per batch
+	static constexpr size_t kMaxBatch = 64;
+
+	// States fed during the current batch (worker thread only)
+	bool voice_dirty_{false};
+	bool bgm_dirty_{false};
+	bool mix_dirty_{false};
+
+	// Loudness meters (owned by worker thread)
+	LoudnessMeter voice_meter_;
+	LoudnessMeter bgm_meter_;
+	LoudnessMeter mix_meter_;
+	std::atomic<LoudnessWindow> loudness_window_{LoudnessWindow::Shortterm};
+	LoudnessWindow window_{LoudnessWindow::Shortterm}; // Consumer side copy, set by SetWindow commands
+
+	// Integrated loudness and range of the meters above since start (attached by init_loudness_meters; kept
+	// across the meter resets on voice release)
+	ProgrammeLoudness voice_programme_;
+	ProgrammeLoudness bgm_programme_;
+	ProgrammeLoudness mix_programme_;
+
+	// K-weighting for every meter above, each BgmInput::loudness and each joined TrackInput::loudness, filtered
+	// together once per batch
+	// (once per block in the derived mix mode, where the mix meter has no lanes)
+	// Each stream takes channels_ consecutive lanes starting at lane(stream)
+	KWeightingBank kweighting_;
+	static constexpr size_t kStreamVoice = 0;
+	static constexpr size_t kStreamBgm = 1;
+	static constexpr size_t kStreamMix = 2;
+	static constexpr size_t kStreamSources = 3; // + BGM input index
+	static constexpr size_t kStreamTracks = kStreamSources + kMaxBgmInputs; // + track index
+	static_assert((kStreamTracks + kMaxTrackInputs) * kMaxChannels <= KWeightingBank::kMaxLanes,
+		      "K-weighting bank too narrow");
+	size_t lane(size_t stream) const { return stream * channels_; }
+
+	// Layout the queues, buses and lanes are sized for (consumer side copy, set by allocate_queues)
+	std::atomic<ChannelLayout> layout_{ChannelLayout::Mono};
+	uint32_t channels_{1};
+	double channel_weights_[kMaxChannels]{};
+
+	// Planar blocks read from the buses (kMaxSamples frames of channels_ planes)
+	std::vector<float> bgm_block_;
+	std::vector<float> mix_block_;
+	std::vector<uint8_t> mix_gate_;
+
+	// VAD
+	VoiceActivityDetector vad_;
+	bool voice_released_{false}; // The VAD released since the voice windows were last reset
+	PrerollRing voice_preroll_;  // Voice since the last activation (sized by configure_buses)
+
+	// Peak tracking (per-frame max)
+	std::atomic<double> voice_peak_{0.0};
+	std::atomic<double> bgm_peak_{0.0};
+	std::atomic<double> mix_peak_{0.0};
+
+	// True peak (worker thread only); the maxima cover the current batch
+	TruePeakDetector voice_true_peak_;
+	TruePeakDetector bgm_true_peak_;
+	TruePeakDetector mix_true_peak_;
+	float voice_true_peak_max_{0.0f};
+	float bgm_true_peak_max_{0.0f};
+	float mix_true_peak_max_{0.0f};
+
+	// Sample rate
+	std::atomic<uint32_t> sample_rate_{48000};
+	uint32_t meter_rate_{48000}; // Rate the meters and filters run at (consumer side, set by init_loudness_meters)
+
+	// Frames fully processed by the worker (published after judgments are updated)
+	std::atomic<uint64_t> processed_frames_{0};
+
+	// Results and config
+	AnalysisResults results_;
+	AnalysisConfig config_;
+};
+
+} // namespace lbm
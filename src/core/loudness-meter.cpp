@@ -0,0 +1,176 @@
+#include "loudness-meter.h"
+
+#include "audio-kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lbm {
+
+LoudnessMeter::LoudnessMeter(uint32_t sample_rate)
+{
+	set_sample_rate(sample_rate);
+}
+
+void LoudnessMeter::set_sample_rate(uint32_t sample_rate)
+{
+	sample_rate_ = sample_rate;
+	filter_ = KWeighting::for_sample_rate(sample_rate);
+	block_samples_ = (sample_rate + 5) / 10;
+	reset();
+}
+
+void LoudnessMeter::reset()
+{
+	for (double &z : z_) {
+		z = 0.0;
+	}
+	for (size_t i = 0; i < kShorttermBlocks; ++i) {
+		blocks_[i] = 0.0;
+		seeded_[i] = 0.0;
+	}
+	block_fill_ = 0;
+	block_energy_ = 0.0;
+	next_block_ = 0;
+	fed_blocks_ = 0;
+	momentary_sum_ = 0.0;
+	shortterm_sum_ = 0.0;
+	seeded_momentary_ = 0.0;
+	seeded_shortterm_ = 0.0;
+}
+
+void LoudnessMeter::add_frames(const float *samples, size_t frames)
+{
+	while (frames > 0) {
+		// Run up to the next sub-block boundary
+		const size_t chunk = (frames < block_samples_ - block_fill_) ? frames : block_samples_ - block_fill_;
+		block_energy_ += filter_.filter(samples, chunk, z_);
+		block_fill_ += chunk;
+		samples += chunk;
+		frames -= chunk;
+
+		if (block_fill_ == block_samples_) {
+			push_block();
+		}
+	}
+}
+
+void LoudnessMeter::add_energy(double energy, size_t frames)
+{
+	block_energy_ += energy;
+	block_fill_ += frames;
+	if (block_fill_ >= block_samples_) {
+		push_block();
+	}
+}
+
+void LoudnessMeter::add_weighted(const float *weighted, size_t frames, size_t stride, uint32_t channels)
+{
+	if (stride == 0) {
+		stride = frames;
+	}
+
+	while (frames > 0) {
+		const size_t chunk = std::min(frames, frames_to_boundary());
+		double energy = 0.0;
+		for (uint32_t c = 0; c < channels; ++c) {
+			energy += kernels::sum_squares(weighted + c * stride, static_cast<uint32_t>(chunk));
+		}
+		add_energy(energy, chunk);
+		weighted += chunk;
+		frames -= chunk;
+	}
+}
+
+void LoudnessMeter::push_block()
+{
+	const size_t slot = next_block_ % kShorttermBlocks;
+	const size_t leaving = (next_block_ + kShorttermBlocks - kMomentaryBlocks) % kShorttermBlocks;
+
+	momentary_sum_ += block_energy_ - blocks_[leaving];
+	shortterm_sum_ += block_energy_ - blocks_[slot];
+	blocks_[slot] = block_energy_;
+	seeded_momentary_ -= seeded_[leaving];
+	seeded_shortterm_ -= seeded_[slot];
+	seeded_[slot] = 0.0;
+	++next_block_;
+	++fed_blocks_;
+
+	// Re-sum once per ring turn so the running sums cannot drift
+	if (slot == kShorttermBlocks - 1) {
+		resum();
+	}
+
+	if (programme_) {
+		// Only fed sub-blocks: the windows are counted from reset() and the sums leave the seeded energies out
+		const double samples = static_cast<double>(block_samples_);
+		if (fed_blocks_ >= kMomentaryBlocks) {
+			programme_->add_gating_block(momentary_sum_ / (kMomentaryBlocks * samples));
+		}
+		if (fed_blocks_ >= kShorttermBlocks && (fed_blocks_ - kShorttermBlocks) % kShorttermHop == 0) {
+			programme_->add_shortterm_block(shortterm_sum_ / (kShorttermBlocks * samples));
+		}
+	}
+
+	block_energy_ = 0.0;
+	block_fill_ = 0;
+}
+
+void LoudnessMeter::resum()
+{
+	momentary_sum_ = 0.0;
+	shortterm_sum_ = 0.0;
+	seeded_momentary_ = 0.0;
+	seeded_shortterm_ = 0.0;
+	for (size_t i = 0; i < kShorttermBlocks; ++i) {
+		shortterm_sum_ += blocks_[i];
+		seeded_shortterm_ += seeded_[i];
+	}
+	for (size_t i = 1; i <= kMomentaryBlocks && i <= next_block_; ++i) {
+		momentary_sum_ += blocks_[(next_block_ - i) % kShorttermBlocks];
+		seeded_momentary_ += seeded_[(next_block_ - i) % kShorttermBlocks];
+	}
+}
+
+void LoudnessMeter::seed(const double *energies, size_t count)
+{
+	reset();
+	merge(energies, count);
+}
+
+void LoudnessMeter::merge(const double *energies, size_t count)
+{
+	count = std::min(count, kShorttermBlocks);
+	if (count == 0) {
+		return;
+	}
+
+	// Sub-blocks a fresh meter has not completed yet were silent so far
+	next_block_ = std::max(next_block_, count);
+	for (size_t i = 0; i < count; ++i) {
+		seeded_[(next_block_ - count + i) % kShorttermBlocks] += energies[i];
+	}
+	resum();
+}
+
+double LoudnessMeter::energy_to_lufs(double energy)
+{
+	if (energy <= 0.0) {
+		return -HUGE_VAL;
+	}
+	return 10.0 * std::log10(energy) - 0.691;
+}
+
+double LoudnessMeter::momentary() const
+{
+	return energy_to_lufs((momentary_sum_ + seeded_momentary_) /
+			      static_cast<double>(kMomentaryBlocks * block_samples_));
+}
+
+double LoudnessMeter::shortterm() const
+{
+	return energy_to_lufs((shortterm_sum_ + seeded_shortterm_) /
+			      static_cast<double>(kShorttermBlocks * block_samples_));
+}
+
+} // namespace lbm
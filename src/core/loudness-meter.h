@@ -0,0 +1,100 @@
+#pragma once
+
+#include "k-weighting.h"
+#include "programme-loudness.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lbm {
+
+// Mono BS.1770 loudness meter with O(1) momentary / short-term queries
+//
+// Samples are K-weighted (the same two-stage filter as libebur128) and their energy is summed per 100 ms
+// sub-block. A 30-slot ring of sub-block energies with running sums gives momentary (last 4 sub-blocks,
+// 400 ms) and short-term (last 30 sub-blocks, 3 s) loudness without keeping any audio. Values advance on
+// 100 ms boundaries; until a window is full the missing sub-blocks count as silence, as in libebur128.
+// add_frames() filters with the meter's own scalar filter; add_energy() takes samples already K-weighted by a
+// KWeightingBank, so several meters can share one vectorized filter pass, and add_weighted() takes K-weighted
+// samples directly.
+// With a ProgrammeLoudness attached, every completed 400 ms / 3 s window (every 100 ms / 1 s once full) is also
+// handed to it for the integrated loudness and loudness range. Sub-block energies seeded or merged from
+// elsewhere are kept in a second ring: they count in momentary() / shortterm() until they leave the windows, but
+// the programme sees the windows of what this meter was fed, exactly as an unseeded meter would.
+//
+// Fixed size, never allocates; not thread-safe (owned by the analysis worker).
+class LoudnessMeter {
+public:
+	explicit LoudnessMeter(uint32_t sample_rate = 48000);
+
+	// Recompute the filter for a new rate and clear all state
+	void set_sample_rate(uint32_t sample_rate);
+	uint32_t sample_rate() const { return sample_rate_; }
+
+	// Clear filter state and energy history (no allocation); an attached programme keeps its blocks
+	void reset();
+
+	// Feed the gating and short-term blocks to `programme` (nullptr detaches); not owned
+	void set_programme(ProgrammeLoudness *programme) { programme_ = programme; }
+
+	void add_frames(const float *samples, size_t frames);
+
+	// Samples left before the current 100 ms sub-block closes
+	size_t frames_to_boundary() const { return block_samples_ - block_fill_; }
+
+	// Add the energy (sum of squares) of `frames` samples K-weighted elsewhere; frames <= frames_to_boundary()
+	void add_energy(double energy, size_t frames);
+
+	// Add samples that are already K-weighted (e.g. a sum of KWeightingBank outputs); any length
+	// With several channels, plane c starts at weighted + c * stride and the energies of all planes add up
+	// (the bank has already applied the channel weights)
+	void add_weighted(const float *weighted, size_t frames, size_t stride = 0, uint32_t channels = 1);
+
+	// Clear the meter and start the window from `count` sub-block energies measured elsewhere (oldest first), as
+	// if they had just been added; an attached programme does not see them
+	void seed(const double *energies, size_t count);
+
+	// Add `count` sub-block energies measured elsewhere to the newest completed sub-blocks (oldest first), as a
+	// source joining a summed stream would have; an attached programme does not see them
+	void merge(const double *energies, size_t count);
+
+	// Loudness in LUFS over the last 400 ms / 3 s of completed sub-blocks (-HUGE_VAL for silence)
+	double momentary() const;
+	double shortterm() const;
+
+	static constexpr size_t kMomentaryBlocks = 4;
+	static constexpr size_t kShorttermBlocks = 30;
+	static constexpr size_t kShorttermHop = 10; // Sub-blocks between the short-term blocks of the loudness range
+
+private:
+	// Close the current sub-block and slide both windows
+	void push_block();
+
+	// Recompute both running sums from the ring
+	void resum();
+
+	static double energy_to_lufs(double energy);
+
+	uint32_t sample_rate_{0};
+	KWeighting filter_{}; // Used by add_frames() only
+	double z_[4]{};       // Transposed direct form II state, two per stage
+
+	size_t block_samples_{0}; // Samples per 100 ms sub-block
+	size_t block_fill_{0};
+	double block_energy_{0.0};
+
+	double blocks_[kShorttermBlocks]{}; // Sub-block energies (sum of squares), ring
+	size_t next_block_{0};
+	size_t fed_blocks_{0}; // Sub-blocks completed since reset(), seeded ones not counted
+	double momentary_sum_{0.0};
+	double shortterm_sum_{0.0};
+
+	// Energies seed() / merge() added, on the same slots as blocks_ until push_block() overwrites them
+	double seeded_[kShorttermBlocks]{};
+	double seeded_momentary_{0.0};
+	double seeded_shortterm_{0.0};
+
+	ProgrammeLoudness *programme_{nullptr};
+};
+
+} // namespace lbm
@@ -0,0 +1,71 @@
+#include "preroll-ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lbm {
+
+void PrerollRing::configure(uint32_t capacity, uint32_t channels)
+{
+	capacity_ = capacity;
+	channels_ = channels > 0 ? channels : 1;
+	ring_ = std::make_unique<float[]>(static_cast<size_t>(capacity_) * channels_);
+	size_ = 0;
+	end_ = 0;
+}
+
+void PrerollRing::push(uint64_t position, const float *samples, uint32_t frames, size_t stride)
+{
+	if (capacity_ == 0 || frames == 0) {
+		return;
+	}
+	if (stride == 0) {
+		stride = frames;
+	}
+
+	// A gap on the timeline: what came before no longer leads up to this block
+	if (size_ > 0 && position != end_) {
+		size_ = 0;
+	}
+	size_ = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(size_) + frames, capacity_));
+	end_ = position + frames;
+
+	// Only the newest capacity_ frames can be kept
+	if (frames > capacity_) {
+		samples += frames - capacity_;
+		position += frames - capacity_;
+		frames = capacity_;
+	}
+
+	while (frames > 0) {
+		const size_t offset = static_cast<size_t>(position % capacity_);
+		const uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(frames, capacity_ - offset));
+		for (uint32_t c = 0; c < channels_; ++c) {
+			float *plane = ring_.get() + static_cast<size_t>(c) * capacity_;
+			std::memcpy(plane + offset, samples + c * stride, chunk * sizeof(float));
+		}
+		samples += chunk;
+		frames -= chunk;
+		position += chunk;
+	}
+}
+
+size_t PrerollRing::latest(uint32_t frames, Piece pieces[2]) const
+{
+	frames = std::min(frames, size_);
+	if (frames == 0) {
+		return 0;
+	}
+
+	const uint64_t start = end_ - frames;
+	const size_t offset = static_cast<size_t>(start % capacity_);
+	const uint32_t first = static_cast<uint32_t>(std::min<size_t>(frames, capacity_ - offset));
+	pieces[0] = Piece{start, ring_.get() + offset, first};
+	if (first == frames) {
+		return 1;
+	}
+	pieces[1] = Piece{start + first, ring_.get(), frames - first};
+	return 2;
+}
+
+} // namespace lbm
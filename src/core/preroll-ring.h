@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace lbm {
+
+// Newest samples of one stream with their timeline positions (worker thread only)
+//
+// Keeps the last capacity() frames of a contiguous stretch of the timeline, one plane per channel, so samples
+// that were passed over can be measured after the fact (the speech onset the VAD attack time holds back). A
+// block that does not continue the stretch starts a new one.
+//
+// All storage is allocated by configure(); push() and latest() never allocate.
+class PrerollRing {
+public:
+	// Contiguous piece of the ring: plane c starts at samples + c * stride()
+	struct Piece {
+		uint64_t position;
+		const float *samples;
+		uint32_t frames;
+	};
+
+	PrerollRing() = default;
+
+	// Non-copyable
+	PrerollRing(const PrerollRing &) = delete;
+	PrerollRing &operator=(const PrerollRing &) = delete;
+
+	// Allocate room for `capacity` frames of `channels` planes and empty the ring
+	void configure(uint32_t capacity, uint32_t channels = 1);
+
+	// Forget the stretch
+	void clear() { size_ = 0; }
+
+	// Append one block at `position` (plane c at samples + c * stride; stride 0: `frames` apart)
+	void push(uint64_t position, const float *samples, uint32_t frames, size_t stride = 0);
+
+	// The newest `frames` frames (at most size()) as up to two pieces, oldest first; returns the piece count
+	size_t latest(uint32_t frames, Piece pieces[2]) const;
+
+	uint32_t size() const { return size_; }
+	uint32_t capacity() const { return capacity_; }
+	size_t stride() const { return capacity_; }
+
+private:
+	std::unique_ptr<float[]> ring_; // channels_ planes of capacity_ samples, indexed by position % capacity_
+	uint32_t capacity_{0};
+	uint32_t channels_{1};
+	uint32_t size_{0};
+	uint64_t end_{0}; // Position after the newest sample
+};
+
+} // namespace lbm
@@ -0,0 +1,138 @@
+#include "programme-loudness.h"
+
+#include <cmath>
+
+namespace lbm {
+
+namespace {
+
+constexpr double kAbsoluteGate = -70.0; // LUFS, also the bottom of the histogram
+constexpr double kBinWidth = 0.1;       // LU
+constexpr double kIntegratedGate = 0.1; // Relative gate of the integrated loudness, -10 LU as a power ratio
+constexpr double kRangeGate = 0.01;     // Relative gate of the loudness range, -20 LU as a power ratio
+
+double power_to_lufs(double power)
+{
+	return 10.0 * std::log10(power) - 0.691;
+}
+
+double lufs_to_power(double lufs)
+{
+	return std::pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+double bin_centre(size_t bin)
+{
+	return kAbsoluteGate + (static_cast<double>(bin) + 0.5) * kBinWidth;
+}
+
+// Bin of a block at `power`; powers above the histogram clamp to the top bin
+size_t bin_of(double power)
+{
+	const double bin = (power_to_lufs(power) - kAbsoluteGate) / kBinWidth;
+	if (bin <= 0.0) {
+		return 0;
+	}
+	return bin >= ProgrammeLoudness::kBins - 1 ? ProgrammeLoudness::kBins - 1 : static_cast<size_t>(bin);
+}
+
+// First bin a relative gate at `threshold` keeps: the bin holding the threshold counts when its centre is at
+// or above it, as in libebur128
+size_t first_bin_above(double threshold)
+{
+	if (threshold < lufs_to_power(kAbsoluteGate)) {
+		return 0;
+	}
+	const size_t bin = bin_of(threshold);
+	return threshold > lufs_to_power(bin_centre(bin)) ? bin + 1 : bin;
+}
+
+} // namespace
+
+void ProgrammeLoudness::reset()
+{
+	gating_ = Histogram{};
+	shortterm_ = Histogram{};
+}
+
+void ProgrammeLoudness::add(Histogram &histogram, double power)
+{
+	// Absolute gate
+	if (!(power >= lufs_to_power(kAbsoluteGate))) {
+		return;
+	}
+
+	const size_t bin = bin_of(power);
+	++histogram.counts[bin];
+	histogram.energies[bin] += power;
+	++histogram.total;
+}
+
+void ProgrammeLoudness::add_gating_block(double power)
+{
+	add(gating_, power);
+}
+
+void ProgrammeLoudness::add_shortterm_block(double power)
+{
+	add(shortterm_, power);
+}
+
+double ProgrammeLoudness::integrated() const
+{
+	if (gating_.total == 0) {
+		return -HUGE_VAL;
+	}
+
+	double energy = 0.0;
+	for (size_t i = 0; i < kBins; ++i) {
+		energy += gating_.energies[i];
+	}
+	const double threshold = energy / static_cast<double>(gating_.total) * kIntegratedGate;
+
+	energy = 0.0;
+	uint64_t count = 0;
+	for (size_t i = first_bin_above(threshold); i < kBins; ++i) {
+		energy += gating_.energies[i];
+		count += gating_.counts[i];
+	}
+	return count > 0 ? power_to_lufs(energy / static_cast<double>(count)) : -HUGE_VAL;
+}
+
+double ProgrammeLoudness::range() const
+{
+	if (shortterm_.total == 0) {
+		return 0.0;
+	}
+
+	double energy = 0.0;
+	for (size_t i = 0; i < kBins; ++i) {
+		energy += shortterm_.energies[i];
+	}
+	const size_t first = first_bin_above(energy / static_cast<double>(shortterm_.total) * kRangeGate);
+
+	uint64_t count = 0;
+	for (size_t i = first; i < kBins; ++i) {
+		count += shortterm_.counts[i];
+	}
+	if (count == 0) {
+		return 0.0;
+	}
+
+	// 10th and 95th percentiles of the gated blocks, rounded to the nearest block as in libebur128
+	const uint64_t low = static_cast<uint64_t>(static_cast<double>(count - 1) * 0.10 + 0.5);
+	const uint64_t high = static_cast<uint64_t>(static_cast<double>(count - 1) * 0.95 + 0.5);
+
+	size_t i = first;
+	uint64_t seen = shortterm_.counts[i];
+	while (seen <= low) {
+		seen += shortterm_.counts[++i];
+	}
+	const size_t low_bin = i;
+	while (seen <= high) {
+		seen += shortterm_.counts[++i];
+	}
+	return static_cast<double>(i - low_bin) * kBinWidth;
+}
+
+} // namespace lbm
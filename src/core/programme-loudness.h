@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lbm {
+
+// Integrated loudness (BS.1770-4) and loudness range (EBU Tech 3342) of a whole session in constant memory
+//
+// A LoudnessMeter feeds it one 400 ms gating block every 100 ms and one 3 s short-term block every second.
+// Instead of keeping every block, each goes into a histogram of 0.1 LU bins from -70 to +30 LUFS (blocks above
+// +30 land in the top bin), the same layout as libebur128's histogram mode. Each bin also keeps the exact energy
+// sum of its blocks, so the integrated loudness is the true mean of the gated blocks; only the bin holding the
+// relative gate is resolved to its centre. The range is read from the bin centres (0.1 LU resolution).
+//
+// Fixed size (about 24 KB), never allocates; not thread-safe (owned by the analysis worker).
+class ProgrammeLoudness {
+public:
+	// Clear both histograms
+	void reset();
+
+	// Mean square of one 400 ms gating block / one 3 s short-term block (channel weights applied)
+	void add_gating_block(double power);
+	void add_shortterm_block(double power);
+
+	// Integrated loudness in LUFS over everything since reset() (-HUGE_VAL until a block passes the gates)
+	double integrated() const;
+
+	// Loudness range in LU over everything since reset() (0 until a short-term block passes the gates)
+	double range() const;
+
+	static constexpr size_t kBins = 1000;
+
+private:
+	struct Histogram {
+		uint32_t counts[kBins];
+		double energies[kBins]; // Sum of the powers of the blocks in each bin
+		uint64_t total;
+	};
+
+	static void add(Histogram &histogram, double power);
+
+	Histogram gating_{};
+	Histogram shortterm_{};
+};
+
+} // namespace lbm
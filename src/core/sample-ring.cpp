@@ -0,0 +1,164 @@
+#include "sample-ring.h"
+
+#include <algorithm>
+
+namespace lbm {
+
+void SampleRing::allocate(size_t frame_capacity, size_t header_capacity, uint32_t channels, bool hop_energy)
+{
+	channels_ = channels > 0 ? channels : 1;
+	sample_capacity_ = frame_capacity * channels_;
+	samples_ = std::make_unique<float[]>(sample_capacity_);
+	headers_ = std::make_unique<Header[]>(header_capacity + 1);
+	hops_ = hop_energy ? std::make_unique<HopEnergy[]>(header_capacity + 1) : nullptr;
+	header_slots_ = header_capacity + 1;
+
+	write_pos_ = 0;
+	reserved_start_ = 0;
+	head_.store(0, std::memory_order_relaxed);
+	tail_.store(0, std::memory_order_relaxed);
+	read_pos_.store(0, std::memory_order_relaxed);
+	committed_samples_.store(0, std::memory_order_relaxed);
+	released_samples_.store(0, std::memory_order_relaxed);
+}
+
+float *SampleRing::try_reserve(uint32_t frames)
+{
+	const size_t samples = static_cast<size_t>(frames) * channels_;
+	if (frames == 0 || samples > sample_capacity_) {
+		return nullptr;
+	}
+
+	const size_t current_head = head_.load(std::memory_order_relaxed);
+	if ((current_head + 1) % header_slots_ == tail_.load(std::memory_order_acquire)) {
+		return nullptr; // Header ring full
+	}
+
+	// Skip the tail of the ring if the block would wrap
+	uint64_t start = write_pos_;
+	size_t offset = static_cast<size_t>(start % sample_capacity_);
+	if (offset + samples > sample_capacity_) {
+		start += sample_capacity_ - offset;
+		offset = 0;
+	}
+
+	if (start + samples - read_pos_.load(std::memory_order_acquire) > sample_capacity_) {
+		return nullptr; // Sample ring full
+	}
+
+	reserved_start_ = start;
+	return samples_.get() + offset;
+}
+
+bool SampleRing::commit(uint32_t frames, const BlockStats &stats, uint64_t timestamp, uint32_t source_id,
+			const HopEnergy *hops)
+{
+	const size_t current_head = head_.load(std::memory_order_relaxed);
+	headers_[current_head] = Header{reserved_start_, timestamp, frames, source_id, stats};
+	if (hops_) {
+		HopEnergy &slot = hops_[current_head];
+		if (hops) {
+			slot.hop = hops->hop;
+			slot.first = hops->first;
+			slot.pieces = hops->pieces;
+			std::copy(hops->sums, hops->sums + hops->pieces, slot.sums);
+		} else {
+			slot.pieces = 0;
+		}
+	}
+	write_pos_ = reserved_start_ + static_cast<uint64_t>(frames) * channels_;
+	committed_samples_.store(committed_samples_.load(std::memory_order_relaxed) + frames,
+				 std::memory_order_relaxed);
+	head_.store((current_head + 1) % header_slots_, std::memory_order_release);
+
+	// Checked after publishing so a consumer that drains concurrently is never missed
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	return tail_.load(std::memory_order_relaxed) == current_head;
+}
+
+bool SampleRing::try_peek(AudioFrame &frame) const
+{
+	return try_peek_batch(&frame, 1) == 1;
+}
+
+size_t SampleRing::try_peek_batch(AudioFrame *frames, size_t max_frames) const
+{
+	size_t index = tail_.load(std::memory_order_relaxed);
+	const size_t current_head = head_.load(std::memory_order_acquire);
+
+	size_t count = 0;
+	while (index != current_head && count < max_frames) {
+		const Header &header = headers_[index];
+		AudioFrame &frame = frames[count++];
+		frame.samples = samples_.get() + header.start % sample_capacity_;
+		frame.frame_count = header.frame_count;
+		frame.channels = channels_;
+		frame.timestamp = header.timestamp;
+		frame.source_id = header.source_id;
+		frame.stats = header.stats;
+		frame.hops = hops_ ? &hops_[index] : nullptr;
+		index = (index + 1) % header_slots_;
+	}
+	return count;
+}
+
+void SampleRing::release(size_t count)
+{
+	if (count == 0) {
+		return;
+	}
+
+	const size_t current_tail = tail_.load(std::memory_order_relaxed);
+	uint64_t samples = 0;
+	for (size_t i = 0; i < count; ++i) {
+		samples += headers_[(current_tail + i) % header_slots_].frame_count;
+	}
+	released_samples_.store(released_samples_.load(std::memory_order_relaxed) + samples,
+				std::memory_order_relaxed);
+
+	const Header &last = headers_[(current_tail + count - 1) % header_slots_];
+	read_pos_.store(last.start + static_cast<uint64_t>(last.frame_count) * channels_, std::memory_order_release);
+	tail_.store((current_tail + count) % header_slots_, std::memory_order_release);
+}
+
+size_t SampleRing::discard()
+{
+	const size_t current_tail = tail_.load(std::memory_order_relaxed);
+	const size_t current_head = head_.load(std::memory_order_acquire);
+	if (current_tail == current_head) {
+		return 0;
+	}
+
+	const size_t count = (current_head > current_tail) ? (current_head - current_tail)
+							    : (header_slots_ - current_tail + current_head);
+	release(count);
+	return count;
+}
+
+size_t SampleRing::discard_before(uint64_t position)
+{
+	const size_t current_head = head_.load(std::memory_order_acquire);
+	uint64_t released = released_samples_.load(std::memory_order_relaxed);
+	size_t index = tail_.load(std::memory_order_relaxed);
+	size_t count = 0;
+	while (index != current_head && released + headers_[index].frame_count <= position) {
+		released += headers_[index].frame_count;
+		index = (index + 1) % header_slots_;
+		++count;
+	}
+	release(count);
+	return count;
+}
+
+size_t SampleRing::size_approx() const
+{
+	if (header_slots_ == 0) {
+		return 0;
+	}
+
+	const size_t head = head_.load(std::memory_order_relaxed);
+	const size_t tail = tail_.load(std::memory_order_relaxed);
+	return (head >= tail) ? (head - tail) : (header_slots_ - tail + head);
+}
+
+} // namespace lbm
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "audio-frame.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace lbm {
+
+// Lock-free Single-Producer Single-Consumer ring for variable-length planar blocks
+// Blocks are stored back to back in one float ring, each as `channels` planes of its frame count; a small
+// header ring records where each block starts. A block never wraps: if it does not fit before the end of the
+// ring, the producer continues at the start, so every block can be read in place as one contiguous span.
+class SampleRing {
+public:
+	SampleRing() = default;
+	~SampleRing() = default;
+
+	// Non-copyable, non-movable
+	SampleRing(const SampleRing &) = delete;
+	SampleRing &operator=(const SampleRing &) = delete;
+	SampleRing(SampleRing &&) = delete;
+	SampleRing &operator=(SampleRing &&) = delete;
+
+	// Allocate room for `frame_capacity` frames of `channels` samples in at most `header_capacity` blocks and
+	// empty the ring; `hop_energy` adds a HopEnergy to every header (the voice queue, for the VAD)
+	// Not thread-safe: neither producer nor consumer may be active
+	void allocate(size_t frame_capacity, size_t header_capacity, uint32_t channels = 1, bool hop_energy = false);
+
+	// Reserve contiguous space for `frames` frames (producer side): plane c starts at c * frames
+	// Returns nullptr if the ring is full; the block is published by commit()
+	float *try_reserve(uint32_t frames);
+
+	// Publish the block written into the last successful try_reserve() (producer side)
+	// `frames` must be the reserved count (it is the plane stride); `stats` and `hops` travel with the block
+	// (`hops` is kept only if the ring was allocated with hop_energy; nullptr: not split)
+	// Returns true if the consumer had already drained the ring (empty -> non-empty transition)
+	bool commit(uint32_t frames, const BlockStats &stats, uint64_t timestamp, uint32_t source_id = 0,
+		    const HopEnergy *hops = nullptr);
+
+	// Access the oldest block in place (consumer side)
+	// Returns false if the ring is empty; the block stays valid until release()
+	bool try_peek(AudioFrame &frame) const;
+
+	// Access up to `max_frames` queued blocks in place with a single acquire (consumer side)
+	// Returns the number of frames filled, oldest first
+	size_t try_peek_batch(AudioFrame *frames, size_t max_frames) const;
+
+	// Return the oldest `count` peeked blocks to the producer with a single release (consumer side)
+	void release(size_t count = 1);
+
+	// Release every queued block without reading it (consumer side)
+	// Returns the number of blocks discarded
+	size_t discard();
+
+	// Release, without reading them, the queued blocks that ended at or before committed_samples() was
+	// `position` (consumer side); returns the number of blocks discarded
+	size_t discard_before(uint64_t position);
+
+	// True if no block is queued (consumer side)
+	bool empty() const
+	{
+		return tail_.load(std::memory_order_relaxed) == head_.load(std::memory_order_acquire);
+	}
+
+	// Frames committed but not yet released (consumer side; excludes wrap padding)
+	uint64_t queued_samples() const
+	{
+		return committed_samples_.load(std::memory_order_acquire) -
+		       released_samples_.load(std::memory_order_relaxed);
+	}
+
+	// Frames committed since allocate() (any thread; exact once the producer is detached)
+	uint64_t committed_samples() const { return committed_samples_.load(std::memory_order_acquire); }
+
+	// Approximate number of queued blocks (may not be exact due to concurrent access)
+	size_t size_approx() const;
+
+	size_t sample_capacity() const { return sample_capacity_; }
+	uint32_t channels() const { return channels_; }
+
+private:
+	struct Header {
+		uint64_t start;     // Position of the first sample of plane 0 (monotonic, not wrapped)
+		uint64_t timestamp; // Timestamp from OBS
+		uint32_t frame_count;
+		uint32_t source_id;
+		BlockStats stats; // Measured by the producer
+	};
+
+	std::unique_ptr<float[]> samples_;
+	size_t sample_capacity_{0}; // Floats (frames x channels)
+	uint32_t channels_{1};
+
+	// One slot is kept free to tell full from empty
+	std::unique_ptr<Header[]> headers_;
+	std::unique_ptr<HopEnergy[]> hops_; // Same slots as headers_, if allocated with hop_energy
+	size_t header_slots_{0};
+
+	// Producer-owned positions
+	uint64_t write_pos_{0};      // End of the last committed block
+	uint64_t reserved_start_{0}; // Start of the pending reservation
+
+	std::atomic<size_t> head_{0};       // Producer writes headers here
+	std::atomic<size_t> tail_{0};       // Consumer reads headers here
+	std::atomic<uint64_t> read_pos_{0}; // End of the last released block
+
+	// Frame totals for backlog reporting (committed by the producer, released by the consumer)
+	std::atomic<uint64_t> committed_samples_{0};
+	std::atomic<uint64_t> released_samples_{0};
+};
+
+} // namespace lbm
@@ -0,0 +1,31 @@
+#pragma once
+
+// Instruction-set macros for the hand-vectorized kernels (include from .cpp files only)
+//
+//   LBM_SIMD_X86   x86 / x64 (AVX2 kernels are compiled and picked at runtime)
+//   LBM_SIMD_SSE2  SSE2 is part of the baseline
+//   LBM_SIMD_NEON  AArch64 (NEON is always present)
+//   LBM_TARGET_AVX2  marks a function compiled for AVX2
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LBM_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LBM_SIMD_SSE2 1
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define LBM_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC accepts AVX2 intrinsics anywhere; GCC / Clang need the function compiled for the target
+#if defined(__GNUC__) || defined(__clang__)
+#define LBM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LBM_TARGET_AVX2
+#endif
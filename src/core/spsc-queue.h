@@ -7,7 +7,7 @@
 namespace lbm {
 
 // Lock-free Single-Producer Single-Consumer Queue
-// Used for transferring audio frames from audio callback to worker thread
+// Used for handing control commands from the UI thread to the analysis worker (audio goes through SampleRing)
 template<typename T, size_t Capacity> class SPSCQueue {
 public:
 	SPSCQueue() = default;
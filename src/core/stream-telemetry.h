@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace lbm {
+
+// Why a capture block did not reach the analyzer
+enum class DropReason { QueueFull, Oversized, Muted };
+
+// Snapshot of one input stream's pipeline counters
+struct StreamTelemetry {
+	uint64_t pushed_blocks{0};
+	uint64_t pushed_samples{0};
+	uint64_t dropped_full_blocks{0};   // Queue full (worker behind)
+	uint64_t dropped_full_samples{0};
+	uint64_t oversized_blocks{0};      // Larger than AudioFrame::kMaxSamples
+	uint64_t muted_blocks{0};          // Muted callbacks (not measured)
+	uint64_t lag_samples{0};           // Samples waiting when the worker last picked up the queue
+	uint64_t high_water_samples{0};    // Largest lag seen so far
+
+	uint64_t dropped_blocks() const { return dropped_full_blocks + oversized_blocks; }
+};
+
+// Lock-free counters behind StreamTelemetry
+// Push/drop counters are written by the stream's producer, lag/high-water by the worker; any thread may read.
+struct StreamCounters {
+	std::atomic<uint64_t> pushed_blocks{0};
+	std::atomic<uint64_t> pushed_samples{0};
+	std::atomic<uint64_t> dropped_full_blocks{0};
+	std::atomic<uint64_t> dropped_full_samples{0};
+	std::atomic<uint64_t> oversized_blocks{0};
+	std::atomic<uint64_t> muted_blocks{0};
+	std::atomic<uint64_t> lag_samples{0};
+	std::atomic<uint64_t> high_water_samples{0};
+
+	void count_push(uint32_t frames)
+	{
+		pushed_blocks.fetch_add(1, std::memory_order_relaxed);
+		pushed_samples.fetch_add(frames, std::memory_order_relaxed);
+	}
+
+	void count_drop(DropReason reason, uint32_t frames)
+	{
+		switch (reason) {
+		case DropReason::QueueFull:
+			dropped_full_blocks.fetch_add(1, std::memory_order_relaxed);
+			dropped_full_samples.fetch_add(frames, std::memory_order_relaxed);
+			break;
+		case DropReason::Oversized:
+			oversized_blocks.fetch_add(1, std::memory_order_relaxed);
+			break;
+		case DropReason::Muted:
+			muted_blocks.fetch_add(1, std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	// Worker side: record the backlog found at the start of a batch
+	void update_lag(uint64_t queued_samples)
+	{
+		lag_samples.store(queued_samples, std::memory_order_relaxed);
+		if (queued_samples > high_water_samples.load(std::memory_order_relaxed)) {
+			high_water_samples.store(queued_samples, std::memory_order_relaxed);
+		}
+	}
+
+	StreamTelemetry snapshot() const
+	{
+		StreamTelemetry t;
+		t.pushed_blocks = pushed_blocks.load(std::memory_order_relaxed);
+		t.pushed_samples = pushed_samples.load(std::memory_order_relaxed);
+		t.dropped_full_blocks = dropped_full_blocks.load(std::memory_order_relaxed);
+		t.dropped_full_samples = dropped_full_samples.load(std::memory_order_relaxed);
+		t.oversized_blocks = oversized_blocks.load(std::memory_order_relaxed);
+		t.muted_blocks = muted_blocks.load(std::memory_order_relaxed);
+		t.lag_samples = lag_samples.load(std::memory_order_relaxed);
+		t.high_water_samples = high_water_samples.load(std::memory_order_relaxed);
+		return t;
+	}
+
+	// Not thread-safe with respect to the stream's producer
+	void reset()
+	{
+		pushed_blocks.store(0, std::memory_order_relaxed);
+		pushed_samples.store(0, std::memory_order_relaxed);
+		dropped_full_blocks.store(0, std::memory_order_relaxed);
+		dropped_full_samples.store(0, std::memory_order_relaxed);
+		oversized_blocks.store(0, std::memory_order_relaxed);
+		muted_blocks.store(0, std::memory_order_relaxed);
+		lag_samples.store(0, std::memory_order_relaxed);
+		high_water_samples.store(0, std::memory_order_relaxed);
+	}
+};
+
+} // namespace lbm
@@ -0,0 +1,236 @@
+#include "summing-bus.h"
+#include "audio-kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lbm {
+
+void SummingBus::configure(uint64_t max_skew, uint32_t max_block, uint32_t channels, uint32_t hold)
+{
+	// Pending samples never exceed max_skew plus the hold plus one block per accumulate round
+	capacity_ = static_cast<size_t>(max_skew) + hold + 2 * static_cast<size_t>(max_block);
+	channels_ = channels > 0 ? channels : 1;
+	ring_ = std::make_unique<float[]>(capacity_ * channels_);
+	gate_ = std::make_unique<uint8_t[]>(capacity_);
+	max_skew_ = max_skew;
+	hold_ = hold;
+	read_pos_ = 0;
+	end_ = 0;
+
+	for (int i = 0; i < kMaxInputs; ++i) {
+		active_[i] = false;
+		position_[i] = 0;
+	}
+}
+
+void SummingBus::add_input(int input, uint64_t position)
+{
+	if (input < 0 || input >= kMaxInputs || active_[input]) {
+		return;
+	}
+
+	// An idle bus jumps to the new input instead of releasing the gap as silence
+	if (!has_inputs() && position > read_pos_) {
+		restart_at(position);
+	}
+
+	active_[input] = true;
+	position_[input] = position;
+}
+
+void SummingBus::remove_input(int input)
+{
+	if (input >= 0 && input < kMaxInputs) {
+		active_[input] = false;
+	}
+}
+
+bool SummingBus::has_input(int input) const
+{
+	return input >= 0 && input < kMaxInputs && active_[input];
+}
+
+bool SummingBus::has_inputs() const
+{
+	for (int i = 0; i < kMaxInputs; ++i) {
+		if (active_[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t SummingBus::leader() const
+{
+	uint64_t lead = std::max(read_pos_, end_);
+	for (int i = 0; i < kMaxInputs; ++i) {
+		if (active_[i]) {
+			lead = std::max(lead, position_[i]);
+		}
+	}
+	return lead;
+}
+
+uint64_t SummingBus::next_position(int input) const
+{
+	if (input < 0 || input >= kMaxInputs || !active_[input]) {
+		return leader();
+	}
+
+	const uint64_t lead = leader();
+	if (position_[input] + max_skew_ < lead) {
+		return lead;
+	}
+	return position_[input];
+}
+
+void SummingBus::accumulate(int input, uint64_t position, const float *samples, uint32_t frames, bool gate,
+			    size_t stride)
+{
+	if (input < 0 || input >= kMaxInputs || !active_[input] || !ring_) {
+		return;
+	}
+	if (stride == 0) {
+		stride = frames;
+	}
+
+	uint64_t pos = position;
+	position_[input] = pos + frames;
+
+	// Skip the part that was already released
+	if (pos < read_pos_) {
+		const uint64_t late = std::min<uint64_t>(read_pos_ - pos, frames);
+		samples += late;
+		frames -= static_cast<uint32_t>(late);
+		pos += late;
+	}
+
+	// Never overrun unreleased samples (a jump ahead of the window keeps only what fits)
+	const uint64_t limit = read_pos_ + capacity_;
+	if (pos + frames > limit) {
+		frames = (pos < limit) ? static_cast<uint32_t>(limit - pos) : 0;
+	}
+	if (frames > 0) {
+		end_ = std::max(end_, pos + frames);
+	}
+
+	while (frames > 0) {
+		const size_t offset = static_cast<size_t>(pos % capacity_);
+		const uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(frames, capacity_ - offset));
+		for (uint32_t c = 0; c < channels_; ++c) {
+			kernels::accumulate(ring_.get() + c * capacity_ + offset, samples + c * stride, chunk);
+		}
+		if (gate) {
+			std::memset(gate_.get() + offset, 1, chunk);
+		}
+		samples += chunk;
+		frames -= chunk;
+		pos += chunk;
+	}
+}
+
+void SummingBus::skip(int input, uint64_t position, uint32_t frames)
+{
+	if (input < 0 || input >= kMaxInputs || !active_[input] || frames == 0) {
+		return;
+	}
+
+	// Unwritten slots are already silent; only the input and the written range move on
+	position_[input] = position + frames;
+	end_ = std::max(end_, std::min<uint64_t>(position + frames, read_pos_ + capacity_));
+}
+
+void SummingBus::set_gate(uint64_t from, uint64_t to)
+{
+	if (!gate_) {
+		return;
+	}
+
+	from = std::max(from, read_pos_);
+	to = std::min<uint64_t>(to, read_pos_ + capacity_);
+	while (from < to) {
+		const size_t offset = static_cast<size_t>(from % capacity_);
+		const size_t chunk = static_cast<size_t>(std::min<uint64_t>(to - from, capacity_ - offset));
+		std::memset(gate_.get() + offset, 1, chunk);
+		from += chunk;
+	}
+}
+
+uint64_t SummingBus::watermark() const
+{
+	bool any = false;
+	uint64_t lead = 0;
+	for (int i = 0; i < kMaxInputs; ++i) {
+		if (active_[i]) {
+			lead = any ? std::max(lead, position_[i]) : position_[i];
+			any = true;
+		}
+	}
+	if (!any) {
+		// Release whatever departed inputs left behind
+		return std::max(read_pos_, end_);
+	}
+
+	// Slowest input that is still within max_skew of the leader
+	const uint64_t floor = (lead > max_skew_) ? lead - max_skew_ : 0;
+	uint64_t mark = lead;
+	for (int i = 0; i < kMaxInputs; ++i) {
+		if (active_[i] && position_[i] >= floor) {
+			mark = std::min(mark, position_[i]);
+		}
+	}
+
+	// Keep the hold back, never beyond what the ring holds
+	mark = std::max(mark, floor);
+	mark = (mark > hold_) ? mark - hold_ : 0;
+	mark = std::min<uint64_t>(mark, read_pos_ + capacity_);
+	return std::max(mark, read_pos_);
+}
+
+size_t SummingBus::available() const
+{
+	return static_cast<size_t>(watermark() - read_pos_);
+}
+
+size_t SummingBus::read(float *out, uint8_t *gate, size_t max_frames)
+{
+	size_t frames = std::min(available(), max_frames);
+	size_t done = 0;
+
+	while (done < frames) {
+		const size_t offset = static_cast<size_t>(read_pos_ % capacity_);
+		const size_t chunk = std::min(frames - done, capacity_ - offset);
+
+		// Hand out the sum and clear the slots for the next round of accumulation
+		for (uint32_t c = 0; c < channels_; ++c) {
+			float *plane = ring_.get() + c * capacity_ + offset;
+			std::memcpy(out + c * frames + done, plane, chunk * sizeof(float));
+			std::memset(plane, 0, chunk * sizeof(float));
+		}
+		if (gate) {
+			std::memcpy(gate + done, gate_.get() + offset, chunk);
+		}
+		std::memset(gate_.get() + offset, 0, chunk);
+		done += chunk;
+		read_pos_ += chunk;
+	}
+	return frames;
+}
+
+void SummingBus::restart_at(uint64_t position)
+{
+	while (read_pos_ < end_) {
+		const size_t offset = static_cast<size_t>(read_pos_ % capacity_);
+		const size_t chunk = static_cast<size_t>(std::min<uint64_t>(end_ - read_pos_, capacity_ - offset));
+		for (uint32_t c = 0; c < channels_; ++c) {
+			std::memset(ring_.get() + c * capacity_ + offset, 0, chunk * sizeof(float));
+		}
+		std::memset(gate_.get() + offset, 0, chunk);
+		read_pos_ += chunk;
+	}
+	read_pos_ = position;
+	end_ = position;
+}
+
+} // namespace lbm
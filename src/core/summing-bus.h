@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace lbm {
+
+// Time-indexed summing bus (worker thread only)
+//
+// Every input writes planar blocks (one plane per channel) at absolute sample positions on a timeline shared
+// with the other inputs
+// (see TimelineClock), so blocks are summed sample-aligned however OBS splits them into callbacks. Positions
+// nobody wrote to read back as silence, so the output covers the timeline without holes.
+//
+// The sum is released up to the position every input has reached. An input that falls more than max_skew
+// samples behind the leading one (paused media, stalled source) is treated as silent so it cannot hold the
+// bus back; next_position() then moves it up to the leader.
+//
+// Each sample also carries a gate flag (OR of the gates of the blocks written there), used to mark the
+// samples where the voice was active. A bus configured with a hold keeps its newest `hold` samples back, so
+// gates can still be set on them after the fact (the speech onset found once the VAD has fired).
+//
+// All storage is allocated by configure(); accumulate() and read() never allocate.
+class SummingBus {
+public:
+	static constexpr int kMaxInputs = 8;
+
+	SummingBus() = default;
+
+	// Non-copyable
+	SummingBus(const SummingBus &) = delete;
+	SummingBus &operator=(const SummingBus &) = delete;
+
+	// Allocate the rings for `channels` planes and drop all inputs and pending samples
+	// `max_block` is the largest block accumulate() will be given; `hold` samples behind the slowest input are
+	// kept back while any input is active
+	void configure(uint64_t max_skew, uint32_t max_block, uint32_t channels = 1, uint32_t hold = 0);
+
+	uint32_t channels() const { return channels_; }
+
+	// Join an input whose next block starts at `position`
+	void add_input(int input, uint64_t position);
+
+	// Leave the bus; samples already accumulated are still released
+	void remove_input(int input);
+
+	bool has_input(int input) const;
+	bool has_inputs() const;
+
+	// Position where the input's next block continues its stream, or the leading position if the input
+	// fell out of the skew window
+	uint64_t next_position(int input) const;
+
+	// Furthest position written by any input
+	uint64_t leader() const;
+
+	// Add one block of an input at `position` (parts already released are dropped)
+	// Plane c starts at samples + c * stride (stride 0: the planes are `frames` apart)
+	void accumulate(int input, uint64_t position, const float *samples, uint32_t frames, bool gate = false,
+			size_t stride = 0);
+
+	// Move an input past `frames` samples at `position` without writing them (as if they were silent)
+	void skip(int input, uint64_t position, uint32_t frames);
+
+	// Set the gate of [from, to); positions already released are left alone
+	void set_gate(uint64_t from, uint64_t to);
+
+	// Timeline position of the next sample read() returns
+	uint64_t read_position() const { return read_pos_; }
+
+	// Number of summed samples ready to read
+	size_t available() const;
+
+	// Copy up to `max_frames` summed frames (and their gate flags, if `gate` is not null) and release them
+	// The planes are written back to back, as many samples apart as the returned count
+	size_t read(float *out, uint8_t *gate, size_t max_frames);
+
+	// Largest possible available() (frames per plane of the buffer read() should be given)
+	size_t capacity() const { return capacity_; }
+
+private:
+	// Bus position up to which every input is complete (laggards beyond max_skew excluded)
+	uint64_t watermark() const;
+
+	// Zero [read_pos_, end_) and move read_pos_ to `position` (no input active)
+	void restart_at(uint64_t position);
+
+	std::unique_ptr<float[]> ring_; // channels_ planes of capacity_ samples
+	std::unique_ptr<uint8_t[]> gate_;
+	size_t capacity_{0};
+	uint32_t channels_{1};
+	uint64_t max_skew_{0};
+	uint32_t hold_{0};
+	uint64_t read_pos_{0};
+	uint64_t end_{0};
+
+	bool active_[kMaxInputs]{};
+	uint64_t position_[kMaxInputs]{};
+};
+
+} // namespace lbm
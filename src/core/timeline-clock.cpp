@@ -0,0 +1,51 @@
+#include "timeline-clock.h"
+
+#include <cmath>
+
+namespace lbm {
+
+void TimelineClock::reset(uint32_t sample_rate)
+{
+	sample_rate_ = sample_rate;
+	anchored_ = false;
+	epoch_ns_ = 0;
+	epoch_position_ = 0;
+}
+
+uint64_t TimelineClock::apply_sync_offset(uint64_t timestamp, int64_t sync_offset)
+{
+	if (timestamp == 0) {
+		return 0;
+	}
+	const int64_t shifted = static_cast<int64_t>(timestamp) + sync_offset;
+	return shifted > 0 ? static_cast<uint64_t>(shifted) : 1;
+}
+
+uint64_t TimelineClock::place(uint64_t expected, uint64_t timestamp, uint64_t now)
+{
+	if (timestamp == 0) {
+		return expected;
+	}
+
+	// The first timestamped block defines the mapping
+	if (!anchored_) {
+		anchored_ = true;
+		epoch_ns_ = timestamp;
+		epoch_position_ = expected;
+		return expected;
+	}
+
+	const int64_t delta_ns = static_cast<int64_t>(timestamp - epoch_ns_);
+	const double offset = static_cast<double>(delta_ns) * 1e-9 * sample_rate_;
+	const double position = static_cast<double>(epoch_position_) + std::round(offset);
+
+	if (position < 0.0 || std::fabs(position - static_cast<double>(now)) > kMaxOffsetSeconds * sample_rate_) {
+		return expected;
+	}
+	if (std::fabs(position - static_cast<double>(expected)) <= kJitterSeconds * sample_rate_) {
+		return expected;
+	}
+	return static_cast<uint64_t>(position);
+}
+
+} // namespace lbm
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lbm {
+
+// Maps OBS audio timestamps (ns, sync offset applied) onto the sample timeline shared by all streams
+//
+// A stream normally continues where its previous block ended; the timestamp only moves it when the two
+// disagree by more than the jitter tolerance (source restarted, paused, dropped blocks). Timestamps that
+// land far from the current timeline position come from a different clock and are ignored, as are zero
+// timestamps (offline tools that push without them).
+class TimelineClock {
+public:
+	// Forget the epoch (next timestamp re-anchors the timeline)
+	void reset(uint32_t sample_rate);
+
+	// Position of a block's first sample
+	// expected: where the stream would continue; now: leading position of the timeline
+	uint64_t place(uint64_t expected, uint64_t timestamp, uint64_t now);
+
+	// Apply a source's sync offset (obs_source_get_sync_offset) to a capture callback timestamp,
+	// which OBS hands out unshifted; 0 stays "unknown"
+	static uint64_t apply_sync_offset(uint64_t timestamp, int64_t sync_offset);
+
+	// Differences below this are timestamp jitter, not discontinuities (OBS smooths up to 70 ms)
+	static constexpr double kJitterSeconds = 0.04;
+
+	// Timestamps further than this from the leading position are on another clock
+	static constexpr double kMaxOffsetSeconds = 10.0;
+
+private:
+	uint32_t sample_rate_{48000};
+	bool anchored_{false};
+	uint64_t epoch_ns_{0};       // Timestamp of timeline position epoch_position_
+	uint64_t epoch_position_{0};
+};
+
+} // namespace lbm
@@ -0,0 +1,246 @@
+#include "true-peak.h"
+
+#include "simd-target.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace lbm {
+
+namespace {
+
+constexpr size_t kPhases = TruePeakDetector::kPhases;
+constexpr size_t kTaps = TruePeakDetector::kTaps;
+constexpr size_t kHistory = kTaps - 1;
+
+// ITU-R BS.1770-4 Annex 2, Table 1: output phase p at input n is sum_k kCoeffs[p][k] * x[n - k]
+constexpr float kCoeffs[kPhases][kTaps] = {
+	{0.0017089843750f, 0.0109863281250f, -0.0196533203125f, 0.0332031250000f, -0.0594482421875f,
+	 0.1373291015625f, 0.9721679687500f, -0.1022949218750f, 0.0476074218750f, -0.0266113281250f,
+	 0.0148925781250f, -0.0083007812500f},
+	{-0.0291748046875f, 0.0292968750000f, -0.0517578125000f, 0.0891113281250f, -0.1665039062500f,
+	 0.4650878906250f, 0.7797851562500f, -0.2003173828125f, 0.1015625000000f, -0.0582275390625f,
+	 0.0330810546875f, -0.0189208984375f},
+	{-0.0189208984375f, 0.0330810546875f, -0.0582275390625f, 0.1015625000000f, -0.2003173828125f,
+	 0.7797851562500f, 0.4650878906250f, -0.1665039062500f, 0.0891113281250f, -0.0517578125000f,
+	 0.0292968750000f, -0.0291748046875f},
+	{-0.0083007812500f, 0.0148925781250f, -0.0266113281250f, 0.0476074218750f, -0.1022949218750f,
+	 0.9721679687500f, 0.1373291015625f, -0.0594482421875f, 0.0332031250000f, -0.0196533203125f,
+	 0.0109863281250f, 0.0017089843750f},
+};
+
+// Reference kernel, one output sample at a time
+float peak_scalar(const float *in, size_t frames)
+{
+	float peak = 0.0f;
+	for (size_t n = 0; n < frames; ++n) {
+		const float *x = in + kHistory + n;
+		for (size_t p = 0; p < kPhases; ++p) {
+			float y = 0.0f;
+			for (size_t k = 0; k < kTaps; ++k) {
+				y += kCoeffs[p][k] * x[-static_cast<ptrdiff_t>(k)];
+			}
+			peak = std::max(peak, std::fabs(y));
+		}
+	}
+	return peak;
+}
+
+// The SIMD kernels compute consecutive output samples of every phase together: each tap is one unaligned load
+// of the input shared by the four phases. The taps are unrolled at compile time so the four sums stay in
+// registers, and are added in the same order as peak_scalar without FMA, so the results match it exactly. The
+// samples left over after the last full vector go through peak_scalar.
+
+#ifdef LBM_SIMD_SSE2
+struct Sse2Phases {
+	__m128 y0, y1, y2, y3;
+};
+
+inline void sse2_tap(Sse2Phases &s, const float *x, size_t k)
+{
+	const __m128 xk = _mm_loadu_ps(x - k);
+	s.y0 = _mm_add_ps(s.y0, _mm_mul_ps(_mm_set1_ps(kCoeffs[0][k]), xk));
+	s.y1 = _mm_add_ps(s.y1, _mm_mul_ps(_mm_set1_ps(kCoeffs[1][k]), xk));
+	s.y2 = _mm_add_ps(s.y2, _mm_mul_ps(_mm_set1_ps(kCoeffs[2][k]), xk));
+	s.y3 = _mm_add_ps(s.y3, _mm_mul_ps(_mm_set1_ps(kCoeffs[3][k]), xk));
+}
+
+template<size_t... K> float sse2_peak(const float *in, size_t frames, std::index_sequence<K...>)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peak = _mm_setzero_ps();
+
+	size_t n = 0;
+	for (; n + 4 <= frames; n += 4) {
+		Sse2Phases s{_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+		(sse2_tap(s, in + kHistory + n, K), ...);
+		peak = _mm_max_ps(peak, _mm_max_ps(_mm_andnot_ps(sign, s.y0), _mm_andnot_ps(sign, s.y1)));
+		peak = _mm_max_ps(peak, _mm_max_ps(_mm_andnot_ps(sign, s.y2), _mm_andnot_ps(sign, s.y3)));
+	}
+
+	peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+	peak = _mm_max_ss(peak, _mm_shuffle_ps(peak, peak, 1));
+	return std::max(_mm_cvtss_f32(peak), peak_scalar(in + n, frames - n));
+}
+
+float peak_sse2(const float *in, size_t frames)
+{
+	return sse2_peak(in, frames, std::make_index_sequence<kTaps>());
+}
+#endif
+
+#ifdef LBM_SIMD_X86
+struct Avx2Phases {
+	__m256 y0, y1, y2, y3;
+};
+
+LBM_TARGET_AVX2 inline void avx2_tap(Avx2Phases &s, const float *x, size_t k)
+{
+	const __m256 xk = _mm256_loadu_ps(x - k);
+	s.y0 = _mm256_add_ps(s.y0, _mm256_mul_ps(_mm256_set1_ps(kCoeffs[0][k]), xk));
+	s.y1 = _mm256_add_ps(s.y1, _mm256_mul_ps(_mm256_set1_ps(kCoeffs[1][k]), xk));
+	s.y2 = _mm256_add_ps(s.y2, _mm256_mul_ps(_mm256_set1_ps(kCoeffs[2][k]), xk));
+	s.y3 = _mm256_add_ps(s.y3, _mm256_mul_ps(_mm256_set1_ps(kCoeffs[3][k]), xk));
+}
+
+template<size_t... K>
+LBM_TARGET_AVX2 float avx2_peak(const float *in, size_t frames, std::index_sequence<K...>)
+{
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 peak = _mm256_setzero_ps();
+
+	size_t n = 0;
+	for (; n + 8 <= frames; n += 8) {
+		Avx2Phases s{_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+		(avx2_tap(s, in + kHistory + n, K), ...);
+		peak = _mm256_max_ps(peak, _mm256_max_ps(_mm256_andnot_ps(sign, s.y0), _mm256_andnot_ps(sign, s.y1)));
+		peak = _mm256_max_ps(peak, _mm256_max_ps(_mm256_andnot_ps(sign, s.y2), _mm256_andnot_ps(sign, s.y3)));
+	}
+
+	__m128 half = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+	half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+	half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+	return std::max(_mm_cvtss_f32(half), peak_scalar(in + n, frames - n));
+}
+
+LBM_TARGET_AVX2 float peak_avx2(const float *in, size_t frames)
+{
+	return avx2_peak(in, frames, std::make_index_sequence<kTaps>());
+}
+#endif
+
+#ifdef LBM_SIMD_NEON
+struct NeonPhases {
+	float32x4_t y0, y1, y2, y3;
+};
+
+inline void neon_tap(NeonPhases &s, const float *x, size_t k)
+{
+	const float32x4_t xk = vld1q_f32(x - k);
+	s.y0 = vaddq_f32(s.y0, vmulq_n_f32(xk, kCoeffs[0][k]));
+	s.y1 = vaddq_f32(s.y1, vmulq_n_f32(xk, kCoeffs[1][k]));
+	s.y2 = vaddq_f32(s.y2, vmulq_n_f32(xk, kCoeffs[2][k]));
+	s.y3 = vaddq_f32(s.y3, vmulq_n_f32(xk, kCoeffs[3][k]));
+}
+
+template<size_t... K> float neon_peak(const float *in, size_t frames, std::index_sequence<K...>)
+{
+	float32x4_t peak = vdupq_n_f32(0.0f);
+
+	size_t n = 0;
+	for (; n + 4 <= frames; n += 4) {
+		NeonPhases s{vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f)};
+		(neon_tap(s, in + kHistory + n, K), ...);
+		peak = vmaxq_f32(peak, vmaxq_f32(vabsq_f32(s.y0), vabsq_f32(s.y1)));
+		peak = vmaxq_f32(peak, vmaxq_f32(vabsq_f32(s.y2), vabsq_f32(s.y3)));
+	}
+
+	return std::max(vmaxvq_f32(peak), peak_scalar(in + n, frames - n));
+}
+
+float peak_neon(const float *in, size_t frames)
+{
+	return neon_peak(in, frames, std::make_index_sequence<kTaps>());
+}
+#endif
+
+} // namespace
+
+TruePeakDetector::TruePeakDetector()
+{
+	set_simd_level(detect_simd_level());
+}
+
+void TruePeakDetector::set_simd_level(SimdLevel level)
+{
+	if (!simd_level_supported(level)) {
+		level = detect_simd_level();
+	}
+	level_ = level;
+
+	switch (level) {
+#ifdef LBM_SIMD_SSE2
+	case SimdLevel::SSE2:
+		kernel_ = peak_sse2;
+		break;
+#endif
+#ifdef LBM_SIMD_X86
+	case SimdLevel::AVX2:
+		kernel_ = peak_avx2;
+		break;
+#endif
+#ifdef LBM_SIMD_NEON
+	case SimdLevel::NEON:
+		kernel_ = peak_neon;
+		break;
+#endif
+	default:
+		kernel_ = peak_scalar;
+		break;
+	}
+}
+
+void TruePeakDetector::set_channels(uint32_t channels)
+{
+	channels_ = std::clamp<uint32_t>(channels, 1, kMaxChannels);
+	reset();
+}
+
+float TruePeakDetector::process(const float *samples, size_t frames, size_t stride)
+{
+	if (stride == 0) {
+		stride = frames;
+	}
+
+	float peak = 0.0f;
+	for (uint32_t c = 0; c < channels_; ++c) {
+		float *buffer = buffer_[c];
+		const float *in = samples + c * stride;
+		size_t left = frames;
+		while (left > 0) {
+			const size_t chunk = std::min(left, kChunk);
+			std::memcpy(buffer + kHistory, in, chunk * sizeof(float));
+			peak = std::max(peak, kernel_(buffer, chunk));
+
+			// Keep the last kHistory inputs for the next chunk
+			std::memmove(buffer, buffer + chunk, kHistory * sizeof(float));
+			in += chunk;
+			left -= chunk;
+		}
+	}
+	return peak;
+}
+
+void TruePeakDetector::reset()
+{
+	std::memset(buffer_, 0, sizeof(buffer_));
+}
+
+double TruePeakDetector::to_dbtp(double peak)
+{
+	return (peak > 0.0) ? 20.0 * std::log10(peak) : -HUGE_VAL;
+}
+
+} // namespace lbm
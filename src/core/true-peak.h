@@ -0,0 +1,59 @@
+#pragma once
+
+#include "channel-layout.h"
+#include "k-weighting.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lbm {
+
+// BS.1770-4 Annex 2 true-peak meter for one stream of up to kMaxChannels planar channels
+//
+// Oversamples 4x with the 48-tap polyphase FIR of Annex 2 (12 taps per phase) and takes the largest absolute
+// value of all four phases, so peaks between samples that a later resampler or encoder would reconstruct are
+// counted. The last 11 input samples of each channel carry over between blocks. The filter runs over 4 (SSE2 /
+// NEON) or 8 (AVX2) output samples per instruction, chosen with detect_simd_level().
+//
+// Fixed size, never allocates; not thread-safe (owned by the analysis worker).
+class TruePeakDetector {
+public:
+	static constexpr size_t kPhases = 4;
+	static constexpr size_t kTaps = 12; // Per phase
+
+	TruePeakDetector();
+
+	// Force a kernel (clamped to what the CPU supports)
+	void set_simd_level(SimdLevel level);
+	SimdLevel simd_level() const { return level_; }
+
+	// Number of planes process() reads (clamped to 1..kMaxChannels); forgets the carried-over samples
+	void set_channels(uint32_t channels);
+	uint32_t channels() const { return channels_; }
+
+	// Largest |sample| of the 4x oversampled block over all channels (linear, 0 for silence)
+	// Plane c starts at samples + c * stride (stride 0: the planes are `frames` apart)
+	float process(const float *samples, size_t frames, size_t stride = 0);
+
+	// Forget the carried-over samples
+	void reset();
+
+	// Convert a linear true peak to dBTP (-HUGE_VAL for silence)
+	static double to_dbtp(double peak);
+
+private:
+	static constexpr size_t kHistory = kTaps - 1;
+	static constexpr size_t kChunk = 256;
+
+	// Peak of the outputs for in[kHistory, kHistory + frames), where in[0, kHistory) is the previous input
+	using Kernel = float (*)(const float *in, size_t frames);
+
+	SimdLevel level_{SimdLevel::Scalar};
+	Kernel kernel_{nullptr};
+	uint32_t channels_{1};
+
+	// Per channel: history followed by the chunk being measured
+	alignas(32) float buffer_[kMaxChannels][kHistory + kChunk]{};
+};
+
+} // namespace lbm
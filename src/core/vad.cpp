@@ -1,4 +1,7 @@
 #include "vad.h"
+#include "audio-kernels.h"
+
+#include <algorithm>
 #include <cmath>
 
 namespace lbm {
@@ -33,6 +36,10 @@ void VoiceActivityDetector::set_sample_rate(uint32_t sample_rate)
 	// Recalculate sample counts with default timing
 	set_attack_time(kDefaultAttackMs);
 	set_release_time(kDefaultReleaseMs);
+
+	hop_samples_ = hop_samples(sample_rate);
+	hop_fill_ = 0;
+	hop_energy_ = 0.0;
 }
 
 double VoiceActivityDetector::attack_time_ms() const
@@ -49,13 +56,73 @@ double VoiceActivityDetector::release_time_ms() const
 	return (sr > 0) ? (samples * 1000.0 / sr) : kDefaultReleaseMs;
 }
 
-bool VoiceActivityDetector::update(const float *samples, uint32_t frame_count)
+uint32_t VoiceActivityDetector::hop_samples(uint32_t sample_rate)
+{
+	return std::max<uint32_t>((sample_rate + kHopsPerSecond / 2) / kHopsPerSecond, 1);
+}
+
+uint32_t VoiceActivityDetector::update(const float *samples, uint32_t frames, size_t stride, uint32_t channels)
 {
-	if (!samples || frame_count == 0) {
-		return is_active_.load(std::memory_order_relaxed);
+	if (stride == 0) {
+		stride = frames;
+	}
+
+	const bool was_active = is_active_.load(std::memory_order_relaxed);
+	uint32_t done = 0;
+	while (done < frames) {
+		// The hop may already be over-full when the split sums were used for part of it
+		const uint32_t chunk = std::min(frames - done, hop_samples_ - std::min(hop_fill_, hop_samples_));
+		for (uint32_t c = 0; c < channels; ++c) {
+			hop_energy_ += kernels::sum_squares(samples + c * stride + done, chunk);
+		}
+		hop_fill_ += chunk;
+		done += chunk;
+
+		if (hop_fill_ >= hop_samples_) {
+			// Mean power per channel, so centred speech reads the same in any layout
+			decide(hop_energy_ / channels, hop_fill_);
+			hop_energy_ = 0.0;
+			hop_fill_ = 0;
+			if (is_active_.load(std::memory_order_relaxed) != was_active) {
+				break;
+			}
+		}
 	}
+	return done;
+}
 
-	double level_dbfs = calculate_rms_dbfs(samples, frame_count);
+uint32_t VoiceActivityDetector::update(const AudioFrame &frame, uint32_t offset)
+{
+	const HopEnergy *hops = frame.hops;
+	if (!hops || hops->pieces == 0 || hops->hop != hop_samples_) {
+		return update(frame.samples + offset, frame.frame_count - offset, frame.frame_count, frame.channels);
+	}
+
+	// The hop ends are the producer's, counted over every committed frame; after a reset the first hop decided
+	// is just shorter
+	const bool was_active = is_active_.load(std::memory_order_relaxed);
+	uint32_t done = offset;
+	for (uint32_t i = hops->piece_at(offset); i < hops->pieces; ++i) {
+		const uint32_t end = hops->end(i, frame.frame_count);
+		hop_energy_ += hops->sums[i];
+		hop_fill_ += end - done;
+		done = end;
+
+		if (hops->ends_hop(i, frame.frame_count)) {
+			decide(hop_energy_ / frame.channels, hop_fill_);
+			hop_energy_ = 0.0;
+			hop_fill_ = 0;
+			if (is_active_.load(std::memory_order_relaxed) != was_active) {
+				break;
+			}
+		}
+	}
+	return done - offset;
+}
+
+void VoiceActivityDetector::decide(double sum_squares, uint32_t frames)
+{
+	double level_dbfs = calculate_rms_dbfs(sum_squares, frames);
 	double threshold = threshold_dbfs_.load(std::memory_order_relaxed);
 	bool above_threshold = (level_dbfs >= threshold);
 
@@ -70,10 +137,11 @@ bool VoiceActivityDetector::update(const float *samples, uint32_t frame_count)
 		if (!is_active) {
 			// Accumulate attack counter
 			uint32_t current = attack_counter_.load(std::memory_order_relaxed);
-			current += frame_count;
+			current += frames;
 			attack_counter_.store(current, std::memory_order_relaxed);
 
 			if (current >= attack_target) {
+				onset_samples_ = current;
 				is_active_.store(true, std::memory_order_relaxed);
 				attack_counter_.store(0, std::memory_order_relaxed);
 			}
@@ -85,7 +153,7 @@ bool VoiceActivityDetector::update(const float *samples, uint32_t frame_count)
 		if (is_active) {
 			// Accumulate release counter
 			uint32_t current = release_counter_.load(std::memory_order_relaxed);
-			current += frame_count;
+			current += frames;
 			release_counter_.store(current, std::memory_order_relaxed);
 
 			if (current >= release_target) {
@@ -94,8 +162,6 @@ bool VoiceActivityDetector::update(const float *samples, uint32_t frame_count)
 			}
 		}
 	}
-
-	return is_active_.load(std::memory_order_relaxed);
 }
 
 void VoiceActivityDetector::reset()
@@ -103,21 +169,18 @@ void VoiceActivityDetector::reset()
 	attack_counter_.store(0, std::memory_order_relaxed);
 	release_counter_.store(0, std::memory_order_relaxed);
 	is_active_.store(false, std::memory_order_relaxed);
+	hop_fill_ = 0;
+	hop_energy_ = 0.0;
+	onset_samples_ = 0;
 }
 
-double VoiceActivityDetector::calculate_rms_dbfs(const float *samples, uint32_t frame_count) const
+double VoiceActivityDetector::calculate_rms_dbfs(double sum_squares, uint32_t frame_count)
 {
-	if (!samples || frame_count == 0) {
+	if (frame_count == 0) {
 		return -HUGE_VAL;
 	}
 
-	double sum_sq = 0.0;
-	for (uint32_t i = 0; i < frame_count; ++i) {
-		double s = static_cast<double>(samples[i]);
-		sum_sq += s * s;
-	}
-
-	double rms = std::sqrt(sum_sq / frame_count);
+	double rms = std::sqrt(sum_squares / frame_count);
 	if (rms <= 0.0) {
 		return -HUGE_VAL;
 	}
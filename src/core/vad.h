@@ -0,0 +1,85 @@
+#pragma once
+
+#include "audio-frame.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lbm {
+
+// Voice Activity Detector using threshold-based detection with attack/release
+//
+// The voice stream is re-blocked into fixed 10 ms hops whatever block size OBS delivers: each hop's energy is
+// summed as the samples arrive and one decision is made per completed hop, so the attack / release timing and
+// the cost per second do not depend on the callback size. Queued voice blocks carry their energy already split at
+// the hop ends (HopEnergy, from the capture kernel), so the VAD only adds those sums up.
+class VoiceActivityDetector {
+public:
+	VoiceActivityDetector();
+	~VoiceActivityDetector() = default;
+
+	// Configuration
+	void set_threshold(double threshold_dbfs);
+	void set_attack_time(double attack_ms);
+	void set_release_time(double release_ms);
+	void set_sample_rate(uint32_t sample_rate);
+
+	// Get current configuration
+	double threshold() const { return threshold_dbfs_.load(std::memory_order_relaxed); }
+	double attack_time_ms() const;
+	double release_time_ms() const;
+
+	// Feed samples (`channels` planes `stride` apart; stride 0: `frames` apart) and return how many were
+	// consumed: all of them, or fewer when a hop decision changed the state, so that every run of samples is
+	// measured in one state (is_active() before the call). Call again with the rest.
+	uint32_t update(const float *samples, uint32_t frames, size_t stride = 0, uint32_t channels = 1);
+
+	// Same for a queued block from frame `offset` on (0, or where the previous call stopped), from its hop sums
+	// when they were split for the current hop length; otherwise from the samples
+	uint32_t update(const AudioFrame &frame, uint32_t offset);
+
+	// Hop length at a sample rate, for producers splitting HopEnergy
+	static uint32_t hop_samples(uint32_t sample_rate);
+
+	// Get current VAD state
+	bool is_active() const { return is_active_.load(std::memory_order_relaxed); }
+
+	// Length of the above-threshold stretch behind the last activation, in samples (worker only): the speech
+	// onset the attack time held back, i.e. the last samples fed before is_active() turned true
+	uint32_t onset_samples() const { return onset_samples_; }
+
+	// Reset VAD state
+	void reset();
+
+private:
+	// Decide on one completed hop of `frames` frames (sum of squares per channel)
+	void decide(double sum_squares, uint32_t frames);
+
+	// RMS level of a block in dBFS
+	static double calculate_rms_dbfs(double sum_squares, uint32_t frame_count);
+
+	// Configuration (atomic for thread-safe access)
+	std::atomic<double> threshold_dbfs_{-40.0};
+	std::atomic<uint32_t> attack_samples_{0};
+	std::atomic<uint32_t> release_samples_{0};
+	std::atomic<uint32_t> sample_rate_{48000};
+
+	// State
+	std::atomic<uint32_t> attack_counter_{0};
+	std::atomic<uint32_t> release_counter_{0};
+	std::atomic<bool> is_active_{false};
+
+	// Current hop (worker only)
+	uint32_t hop_samples_{480};
+	uint32_t hop_fill_{0};
+	double hop_energy_{0.0};
+	uint32_t onset_samples_{0};
+
+	// Default timing values
+	static constexpr double kDefaultAttackMs = 150.0;
+	static constexpr double kDefaultReleaseMs = 600.0;
+	static constexpr uint32_t kHopsPerSecond = 100;
+};
+
+} // namespace lbm
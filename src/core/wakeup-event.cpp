@@ -0,0 +1,40 @@
+#include "wakeup-event.h"
+
+namespace lbm {
+
+void WakeupEvent::notify()
+{
+	// Pairs with the fence in prepare_wait(): either the consumer sees the published data
+	// when it re-checks, or we see waiting_ == true here
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!waiting_.load(std::memory_order_relaxed)) {
+		return;
+	}
+	wake();
+}
+
+void WakeupEvent::wake()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		signaled_ = true;
+	}
+	cv_.notify_one();
+}
+
+void WakeupEvent::prepare_wait()
+{
+	waiting_.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+bool WakeupEvent::wait_for(std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	bool notified = cv_.wait_for(lock, timeout, [this] { return signaled_; });
+	signaled_ = false;
+	waiting_.store(false, std::memory_order_relaxed);
+	return notified;
+}
+
+} // namespace lbm
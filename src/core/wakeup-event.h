@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace lbm {
+
+// Wakeup for a single consumer thread that sleeps while its queues are empty
+// Producers call notify() after publishing; it only touches the mutex when the consumer is asleep,
+// so the common case (consumer busy) is one fence and one relaxed load.
+//
+// Consumer protocol (no lost wakeups):
+//   prepare_wait(); if (work available) cancel_wait(); else wait_for(timeout);
+class WakeupEvent {
+public:
+	WakeupEvent() = default;
+
+	// Non-copyable
+	WakeupEvent(const WakeupEvent &) = delete;
+	WakeupEvent &operator=(const WakeupEvent &) = delete;
+
+	// Producer side: wake the consumer if it is waiting or about to wait
+	void notify();
+
+	// Wake the consumer unconditionally (stop requests, control changes)
+	void wake();
+
+	// Consumer side: announce the intent to sleep; re-check for work afterwards
+	void prepare_wait();
+	void cancel_wait() { waiting_.store(false, std::memory_order_relaxed); }
+
+	// Consumer side: sleep until notified or `timeout` elapses; returns true if notified
+	bool wait_for(std::chrono::milliseconds timeout);
+
+private:
+	std::atomic<bool> waiting_{false};
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	bool signaled_{false};
+};
+
+} // namespace lbm
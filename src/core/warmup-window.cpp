@@ -0,0 +1,49 @@
+#include "warmup-window.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lbm {
+
+void WarmupWindow::configure(uint32_t sample_rate, ChannelLayout layout)
+{
+	filter_ = KWeighting::for_sample_rate(sample_rate);
+	sample_rate_ = sample_rate;
+	layout_ = layout;
+	for (uint32_t c = 0; c < kMaxChannels; ++c) {
+		for (double &z : z_[c]) {
+			z = 0.0;
+		}
+		gains_[c] = c < channel_count(layout) ? std::sqrt(channel_weight(layout, c)) : 0.0;
+	}
+
+	block_samples_ = std::max<uint32_t>((sample_rate + 5) / 10, 1);
+	block_fill_ = 0;
+	block_energy_ = 0.0;
+	count_ = 0;
+}
+
+void WarmupWindow::add(const float *const *planes, uint32_t frames, float volume)
+{
+	const uint32_t channels = channel_count(layout_);
+	uint32_t done = 0;
+	while (done < frames) {
+		const uint32_t chunk = std::min(frames - done, block_samples_ - block_fill_);
+		for (uint32_t c = 0; c < channels; ++c) {
+			if (planes[c] && gains_[c] > 0.0) {
+				block_energy_ += filter_.filter(planes[c] + done, chunk, z_[c], gains_[c] * volume);
+			}
+		}
+		block_fill_ += chunk;
+		done += chunk;
+
+		if (block_fill_ == block_samples_) {
+			blocks_[count_ % kHistoryBlocks] = block_energy_;
+			++count_;
+			block_energy_ = 0.0;
+			block_fill_ = 0;
+		}
+	}
+}
+
+} // namespace lbm
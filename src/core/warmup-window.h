@@ -0,0 +1,53 @@
+#pragma once
+
+#include "channel-layout.h"
+#include "k-weighting.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lbm {
+
+// Loudness history of a source that is not being measured, so a meter can start full when it is selected
+//
+// Fed from the source's own capture callback: each block is K-weighted per channel with the BS.1770 channel
+// weights (the same filter as LoudnessMeter, no queue or worker involved) and only the energy of every completed
+// 100 ms sub-block is kept, the last kHistoryBlocks of them. LoudnessAnalyzer::warm_voice() /
+// warm_bgm_input() seed a meter's short-term window from it.
+//
+// Fixed size, never allocates. Not thread-safe: configure before the callback is attached and read after it is
+// removed (OBS serializes both with the callback).
+class WarmupWindow {
+public:
+	static constexpr size_t kHistoryBlocks = 100; // 10 s, room to pick the voiced sub-blocks of the last 3 s
+
+	// Restart the history for blocks of `layout` at `sample_rate`
+	void configure(uint32_t sample_rate, ChannelLayout layout);
+
+	// Add one block (plane c at planes[c], null planes silent) with the volume fader applied
+	void add(const float *const *planes, uint32_t frames, float volume);
+
+	uint32_t sample_rate() const { return sample_rate_; }
+	ChannelLayout layout() const { return layout_; }
+	uint32_t block_samples() const { return block_samples_; }
+
+	// Completed sub-blocks kept, and the energy of one of them (age 0 is the newest)
+	size_t size() const { return count_ < kHistoryBlocks ? static_cast<size_t>(count_) : kHistoryBlocks; }
+	double block(size_t age) const { return blocks_[(count_ - 1 - age) % kHistoryBlocks]; }
+
+private:
+	KWeighting filter_{};
+	double z_[kMaxChannels][4]{};
+	double gains_[kMaxChannels]{}; // sqrt(G), so the squared output is weighted
+	uint32_t sample_rate_{0};
+	ChannelLayout layout_{ChannelLayout::Mono};
+
+	uint32_t block_samples_{0};
+	uint32_t block_fill_{0};
+	double block_energy_{0.0};
+
+	double blocks_[kHistoryBlocks]{}; // Ring of sub-block energies
+	uint64_t count_{0};               // Sub-blocks completed since configure()
+};
+
+} // namespace lbm
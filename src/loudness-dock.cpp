@@ -2,12 +2,15 @@
 #include "plugin-support.h"
 
 #include <obs-frontend-api.h>
+#include <util/platform.h>
 
+#include <QDateTime>
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QScrollArea>
 
+#include <algorithm>
 #include <cmath>
 
 namespace lbm {
@@ -25,6 +28,13 @@ LoudnessDock::LoudnessDock(QWidget *parent) : QWidget(parent)
 		analyzer_->set_sample_rate(sample_rate);
 	}
 
+	// Capture callbacks deliver the output speaker layout; measure every channel of it
+	obs_audio_info audio_info;
+	ChannelLayout layout;
+	if (obs_get_audio_info(&audio_info) && layout_for_channels(get_audio_channels(audio_info.speakers), layout)) {
+		analyzer_->set_channel_layout(layout);
+	}
+
 	setup_ui();
 	load_settings();
 
@@ -169,6 +179,10 @@ void LoudnessDock::setup_ui()
 	voice_peak_label_ = new QLabel("-- dB");
 	voice_peak_label_->setFixedWidth(60);
 	voice_meter_layout->addWidget(voice_peak_label_);
+	voice_true_peak_label_ = new QLabel("-- dBTP");
+	voice_true_peak_label_->setFixedWidth(80);
+	voice_true_peak_label_->setToolTip(obs_module_text("TruePeakTooltip"));
+	voice_meter_layout->addWidget(voice_true_peak_label_);
 	meter_layout->addLayout(voice_meter_layout);
 
 	// BGM meter
@@ -185,6 +199,10 @@ void LoudnessDock::setup_ui()
 	bgm_peak_label_ = new QLabel("-- dB");
 	bgm_peak_label_->setFixedWidth(60);
 	bgm_meter_layout->addWidget(bgm_peak_label_);
+	bgm_true_peak_label_ = new QLabel("-- dBTP");
+	bgm_true_peak_label_->setFixedWidth(80);
+	bgm_true_peak_label_->setToolTip(obs_module_text("TruePeakTooltip"));
+	bgm_meter_layout->addWidget(bgm_true_peak_label_);
 	meter_layout->addLayout(bgm_meter_layout);
 
 	// Mix meter
@@ -201,6 +219,10 @@ void LoudnessDock::setup_ui()
 	mix_peak_label_ = new QLabel("-- dB");
 	mix_peak_label_->setFixedWidth(60);
 	mix_meter_layout->addWidget(mix_peak_label_);
+	mix_true_peak_label_ = new QLabel("-- dBTP");
+	mix_true_peak_label_->setFixedWidth(80);
+	mix_true_peak_label_->setToolTip(obs_module_text("TruePeakTooltip"));
+	mix_meter_layout->addWidget(mix_true_peak_label_);
 	meter_layout->addLayout(mix_meter_layout);
 
 	// Delta display
@@ -212,8 +234,64 @@ void LoudnessDock::setup_ui()
 	delta_layout->addStretch();
 	meter_layout->addLayout(delta_layout);
 
+	// Capture pipeline telemetry (queue lag / dropped blocks)
+	auto *pipeline_layout = new QHBoxLayout();
+	pipeline_layout->addWidget(new QLabel(obs_module_text("Pipeline")));
+	pipeline_label_ = new QLabel("--");
+	pipeline_layout->addWidget(pipeline_label_, 1);
+	meter_layout->addLayout(pipeline_layout);
+
 	main_layout->addWidget(meter_group);
 
+	// === Output Tracks ===
+	auto *track_group = new QGroupBox(obs_module_text("OutputTracks"));
+	auto *track_layout = new QVBoxLayout(track_group);
+
+	// One checkbox per OBS mixer track
+	auto *track_select_layout = new QHBoxLayout();
+	for (int t = 0; t < kMaxOutputTracks; ++t) {
+		TrackRow &row = track_rows_[t];
+		row.checkbox = new QCheckBox(QString::number(t + 1));
+		row.checkbox->setProperty("track", t);
+		row.checkbox->setToolTip(obs_module_text("OutputTracksTooltip"));
+		track_select_layout->addWidget(row.checkbox);
+	}
+	track_select_layout->addStretch();
+	track_layout->addLayout(track_select_layout);
+
+	// Track meters
+	for (int t = 0; t < kMaxOutputTracks; ++t) {
+		TrackRow &row = track_rows_[t];
+		row.row = new QWidget();
+		auto *row_layout = new QHBoxLayout(row.row);
+		row_layout->setContentsMargins(0, 0, 0, 0);
+		row_layout->addWidget(new QLabel(QString(obs_module_text("OutputTrack")).arg(t + 1) + ":"));
+		row.meter = new QProgressBar();
+		row.meter->setRange(0, 100);
+		row.meter->setTextVisible(false);
+		row.meter->setFixedHeight(20);
+		row_layout->addWidget(row.meter, 1);
+		row.lufs_label = new QLabel("-- LUFS");
+		row.lufs_label->setFixedWidth(80);
+		row_layout->addWidget(row.lufs_label);
+		row.peak_label = new QLabel("-- dB");
+		row.peak_label->setFixedWidth(60);
+		row_layout->addWidget(row.peak_label);
+		row.true_peak_label = new QLabel("-- dBTP");
+		row.true_peak_label->setFixedWidth(80);
+		row.true_peak_label->setToolTip(obs_module_text("TruePeakTooltip"));
+		row_layout->addWidget(row.true_peak_label);
+		row.clip_status = new QFrame();
+		row.clip_status->setFixedSize(12, 20);
+		row.clip_status->setFrameStyle(QFrame::Box);
+		row.clip_status->setToolTip(obs_module_text("ClipTooltip"));
+		row_layout->addWidget(row.clip_status);
+		row.row->setVisible(false);
+		track_layout->addWidget(row.row);
+	}
+
+	main_layout->addWidget(track_group);
+
 	// === Settings ===
 	auto *settings_group = new QGroupBox(obs_module_text("Settings"));
 	auto *settings_layout = new QVBoxLayout(settings_group);
@@ -252,6 +330,16 @@ void LoudnessDock::setup_ui()
 	mix_layout->addStretch();
 	settings_layout->addLayout(mix_layout);
 
+	// Background warm-up of recently deselected sources
+	warmup_checkbox_ = new QCheckBox(obs_module_text("WarmupSources"));
+	warmup_checkbox_->setToolTip(obs_module_text("WarmupSourcesTooltip"));
+	settings_layout->addWidget(warmup_checkbox_);
+
+	// Capture callback recording (for offline replay with lbm-replay)
+	record_checkbox_ = new QCheckBox(obs_module_text("RecordCallbacks"));
+	record_checkbox_->setToolTip(obs_module_text("RecordCallbacksTooltip"));
+	settings_layout->addWidget(record_checkbox_);
+
 	main_layout->addWidget(settings_group);
 
 	// === Help Section ===
@@ -300,6 +388,11 @@ void LoudnessDock::setup_ui()
 		&LoudnessDock::on_balance_target_changed);
 	connect(mix_preset_combo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
 		&LoudnessDock::on_mix_preset_changed);
+	connect(warmup_checkbox_, &QCheckBox::toggled, this, &LoudnessDock::on_warmup_toggled);
+	connect(record_checkbox_, &QCheckBox::toggled, this, &LoudnessDock::on_record_toggled);
+	for (const TrackRow &row : track_rows_) {
+		connect(row.checkbox, &QCheckBox::toggled, this, &LoudnessDock::on_output_track_toggled);
+	}
 
 	// Initial source list
 	refresh_source_lists();
@@ -357,6 +450,12 @@ void LoudnessDock::on_update_timer()
 {
 	update_meters();
 	update_status_colors();
+	update_telemetry();
+
+	if (++telemetry_ticks_ >= kTelemetryLogTicks) {
+		telemetry_ticks_ = 0;
+		log_telemetry();
+	}
 }
 
 void LoudnessDock::on_voice_source_changed(int index)
@@ -420,6 +519,54 @@ void LoudnessDock::on_refresh_sources()
 	refresh_source_lists();
 }
 
+void LoudnessDock::on_warmup_toggled(bool checked)
+{
+	capture_manager_->set_warmup_enabled(checked);
+}
+
+void LoudnessDock::on_output_track_toggled(bool checked)
+{
+	auto *cb = qobject_cast<QCheckBox *>(sender());
+	if (!cb)
+		return;
+
+	capture_manager_->set_output_track(cb->property("track").toInt(), checked);
+
+	// Connecting fails without an audio output; show what is really measured
+	sync_track_rows();
+}
+
+void LoudnessDock::on_record_toggled(bool checked)
+{
+	if (!checked) {
+		if (capture_manager_->is_recording()) {
+			capture_manager_->stop_recording();
+			obs_log(LOG_INFO, "Capture recording stopped");
+		}
+		return;
+	}
+
+	char *dir = obs_module_config_path("recordings");
+	if (!dir) {
+		record_checkbox_->setChecked(false);
+		return;
+	}
+	os_mkdirs(dir);
+
+	QString file_name = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".lbmrec";
+	std::string path = std::string(dir) + "/" + file_name.toStdString();
+	bfree(dir);
+
+	if (capture_manager_->start_recording(path)) {
+		obs_log(LOG_INFO, "Capture recording started: %s", path.c_str());
+	} else {
+		obs_log(LOG_WARNING, "Failed to start capture recording: %s", path.c_str());
+		record_checkbox_->blockSignals(true);
+		record_checkbox_->setChecked(false);
+		record_checkbox_->blockSignals(false);
+	}
+}
+
 void LoudnessDock::update_meters()
 {
 	const auto &results = analyzer_->results();
@@ -449,6 +596,9 @@ void LoudnessDock::update_meters()
 	} else {
 		voice_peak_label_->setText("-- dB");
 	}
+	set_true_peak_label(voice_true_peak_label_, results.voice_true_peak_dbtp.load(std::memory_order_relaxed));
+	voice_lufs_label_->setToolTip(programme_text(results.voice_integrated_lufs.load(std::memory_order_relaxed),
+						     results.voice_lra.load(std::memory_order_relaxed)));
 
 	// BGM meter
 	double bgm_lufs = results.bgm_lufs.load(std::memory_order_relaxed);
@@ -465,6 +615,8 @@ void LoudnessDock::update_meters()
 	} else {
 		bgm_peak_label_->setText("-- dB");
 	}
+	set_true_peak_label(bgm_true_peak_label_, results.bgm_true_peak_dbtp.load(std::memory_order_relaxed));
+	update_bgm_breakdown();
 
 	// Mix meter
 	double mix_lufs = results.mix_lufs.load(std::memory_order_relaxed);
@@ -483,6 +635,9 @@ void LoudnessDock::update_meters()
 	} else {
 		mix_peak_label_->setText("-- dB");
 	}
+	set_true_peak_label(mix_true_peak_label_, results.mix_true_peak_dbtp.load(std::memory_order_relaxed));
+	mix_lufs_label_->setToolTip(programme_text(results.mix_integrated_lufs.load(std::memory_order_relaxed),
+						   results.mix_lra.load(std::memory_order_relaxed)));
 
 	// Delta
 	double delta = results.balance_delta.load(std::memory_order_relaxed);
@@ -491,6 +646,8 @@ void LoudnessDock::update_meters()
 	} else {
 		delta_label_->setText("-- LU");
 	}
+
+	update_track_meters();
 }
 
 void LoudnessDock::update_status_colors()
@@ -506,6 +663,182 @@ void LoudnessDock::update_status_colors()
 	clip_status_->setStyleSheet(status_to_style(clip));
 }
 
+void LoudnessDock::update_bgm_breakdown()
+{
+	// Loudest source first, so the tooltip answers "which BGM is too loud"
+	std::vector<AudioCaptureManager::SourceLoudness> sources = capture_manager_->bgm_loudness();
+	std::stable_sort(sources.begin(), sources.end(),
+			 [](const auto &a, const auto &b) { return a.lufs > b.lufs; });
+
+	const auto &results = analyzer_->results();
+	QString tooltip = programme_text(results.bgm_integrated_lufs.load(std::memory_order_relaxed),
+					 results.bgm_lra.load(std::memory_order_relaxed));
+	if (!sources.empty() && sources.front().lufs != -HUGE_VAL) {
+		tooltip += "\n";
+		tooltip += QString(obs_module_text("BGMLoudest")).arg(QString::fromStdString(sources.front().name));
+	}
+	for (const auto &source : sources) {
+		QString lufs = (source.lufs != -HUGE_VAL) ? QString::number(source.lufs, 'f', 1) : "--";
+		QString peak = (source.peak_dbfs != -HUGE_VAL) ? QString::number(source.peak_dbfs, 'f', 1) : "--";
+		QString true_peak =
+			(source.true_peak_dbtp != -HUGE_VAL) ? QString::number(source.true_peak_dbtp, 'f', 1) : "--";
+		if (!tooltip.isEmpty()) {
+			tooltip += "\n";
+		}
+		tooltip += QString(obs_module_text("BGMSourceLoudness"))
+				   .arg(QString::fromStdString(source.name))
+				   .arg(lufs)
+				   .arg(peak)
+				   .arg(true_peak);
+	}
+
+	bgm_meter_->setToolTip(tooltip);
+	bgm_lufs_label_->setToolTip(tooltip);
+}
+
+void LoudnessDock::update_track_meters()
+{
+	const auto &results = analyzer_->results();
+
+	for (int t = 0; t < kMaxOutputTracks; ++t) {
+		TrackRow &row = track_rows_[t];
+		if (!row.checkbox->isChecked()) {
+			continue;
+		}
+
+		const TrackResults &track = results.tracks[t];
+		double lufs = track.lufs.load(std::memory_order_relaxed);
+		double peak = track.peak_dbfs.load(std::memory_order_relaxed);
+		if (lufs != -HUGE_VAL) {
+			row.meter->setValue(lufs_to_meter(lufs));
+			row.lufs_label->setText(QString("%1 LUFS").arg(lufs, 0, 'f', 1));
+		} else {
+			row.meter->setValue(0);
+			row.lufs_label->setText("-- LUFS");
+		}
+		if (peak != -HUGE_VAL) {
+			row.peak_label->setText(QString("%1 dB").arg(peak, 0, 'f', 1));
+		} else {
+			row.peak_label->setText("-- dB");
+		}
+		set_true_peak_label(row.true_peak_label, track.true_peak_dbtp.load(std::memory_order_relaxed));
+		row.lufs_label->setToolTip(programme_text(track.integrated_lufs.load(std::memory_order_relaxed),
+							  track.lra.load(std::memory_order_relaxed)));
+		row.clip_status->setStyleSheet(status_to_style(track.clip_status.load(std::memory_order_relaxed)));
+	}
+}
+
+void LoudnessDock::sync_track_rows()
+{
+	const uint32_t tracks = capture_manager_->output_tracks();
+	for (int t = 0; t < kMaxOutputTracks; ++t) {
+		TrackRow &row = track_rows_[t];
+		const bool measured = (tracks & (1u << t)) != 0;
+		row.checkbox->blockSignals(true);
+		row.checkbox->setChecked(measured);
+		row.checkbox->blockSignals(false);
+		row.row->setVisible(measured);
+	}
+}
+
+std::vector<AudioCaptureManager::SourceTelemetry> LoudnessDock::track_telemetry() const
+{
+	std::vector<AudioCaptureManager::SourceTelemetry> telemetry;
+	const uint32_t tracks = capture_manager_->output_tracks();
+	for (int t = 0; t < kMaxOutputTracks; ++t) {
+		if (tracks & (1u << t)) {
+			telemetry.push_back(AudioCaptureManager::SourceTelemetry{
+				QString(obs_module_text("OutputTrack")).arg(t + 1).toStdString(),
+				analyzer_->track_telemetry(t)});
+		}
+	}
+	return telemetry;
+}
+
+void LoudnessDock::update_telemetry()
+{
+	const double ms_per_sample = 1000.0 / analyzer_->sample_rate();
+
+	std::vector<AudioCaptureManager::SourceTelemetry> streams = capture_manager_->bgm_telemetry();
+	if (capture_manager_->has_voice_source()) {
+		streams.insert(streams.begin(), capture_manager_->voice_telemetry());
+	}
+	for (auto &track : track_telemetry()) {
+		streams.push_back(std::move(track));
+	}
+
+	uint64_t lag = 0;
+	uint64_t high_water = 0;
+	uint64_t dropped = 0;
+	QString tooltip;
+	for (const auto &stream : streams) {
+		const StreamTelemetry &t = stream.stats;
+		lag = std::max(lag, t.lag_samples);
+		high_water = std::max(high_water, t.high_water_samples);
+		dropped += t.dropped_blocks();
+
+		if (!tooltip.isEmpty()) {
+			tooltip += "\n";
+		}
+		tooltip += QString(obs_module_text("PipelineSourceStats"))
+				   .arg(QString::fromStdString(stream.name))
+				   .arg(t.pushed_blocks)
+				   .arg(t.dropped_blocks())
+				   .arg(t.muted_blocks)
+				   .arg(t.lag_samples * ms_per_sample, 0, 'f', 1)
+				   .arg(t.high_water_samples * ms_per_sample, 0, 'f', 1);
+	}
+
+	if (streams.empty()) {
+		pipeline_label_->setText("--");
+		pipeline_label_->setToolTip(QString());
+		pipeline_label_->setStyleSheet(QString());
+		return;
+	}
+
+	pipeline_label_->setText(QString(obs_module_text("PipelineStatus"))
+					 .arg(lag * ms_per_sample, 0, 'f', 0)
+					 .arg(high_water * ms_per_sample, 0, 'f', 0)
+					 .arg(dropped));
+	pipeline_label_->setToolTip(tooltip);
+	pipeline_label_->setStyleSheet(dropped > 0 ? "color: #FFC107;" : QString());
+}
+
+void LoudnessDock::log_telemetry()
+{
+	const double ms_per_sample = 1000.0 / analyzer_->sample_rate();
+	uint64_t dropped = 0;
+
+	auto log_stream = [&](const char *kind, const AudioCaptureManager::SourceTelemetry &stream) {
+		const StreamTelemetry &t = stream.stats;
+		dropped += t.dropped_blocks();
+		obs_log(LOG_INFO,
+			"Pipeline %s '%s': pushed=%llu dropped_full=%llu oversized=%llu muted=%llu "
+			"lag=%.1fms max=%.1fms",
+			kind, stream.name.c_str(), static_cast<unsigned long long>(t.pushed_blocks),
+			static_cast<unsigned long long>(t.dropped_full_blocks),
+			static_cast<unsigned long long>(t.oversized_blocks),
+			static_cast<unsigned long long>(t.muted_blocks), t.lag_samples * ms_per_sample,
+			t.high_water_samples * ms_per_sample);
+	};
+
+	if (capture_manager_->has_voice_source()) {
+		log_stream("voice", capture_manager_->voice_telemetry());
+	}
+	for (const auto &stream : capture_manager_->bgm_telemetry()) {
+		log_stream("bgm", stream);
+	}
+	for (const auto &stream : track_telemetry()) {
+		log_stream("track", stream);
+	}
+
+	if (dropped > logged_drops_) {
+		obs_log(LOG_WARNING, "Pipeline dropped %llu blocks in the last %d s (analysis worker overloaded?)",
+			static_cast<unsigned long long>(dropped - logged_drops_), kTelemetryLogTicks / 10);
+	}
+	logged_drops_ = dropped;
+}
+
 int LoudnessDock::lufs_to_meter(double lufs) const
 {
 	// Map LUFS to 0-100 range
@@ -517,6 +850,21 @@ int LoudnessDock::lufs_to_meter(double lufs) const
 	return static_cast<int>((lufs + 60.0) / 60.0 * 100.0);
 }
 
+void LoudnessDock::set_true_peak_label(QLabel *label, double dbtp) const
+{
+	if (dbtp != -HUGE_VAL) {
+		label->setText(QString("%1 dBTP").arg(dbtp, 0, 'f', 1));
+	} else {
+		label->setText("-- dBTP");
+	}
+}
+
+QString LoudnessDock::programme_text(double integrated_lufs, double lra) const
+{
+	QString integrated = (integrated_lufs != -HUGE_VAL) ? QString::number(integrated_lufs, 'f', 1) : "--";
+	return QString(obs_module_text("ProgrammeLoudness")).arg(integrated).arg(lra, 0, 'f', 1);
+}
+
 QString LoudnessDock::status_to_style(Status status) const
 {
 	switch (status) {
@@ -545,6 +893,7 @@ void LoudnessDock::save_settings()
 	obs_data_set_int(settings, "vad_threshold", vad_threshold_slider_->value());
 	obs_data_set_double(settings, "balance_target", balance_target_spin_->value());
 	obs_data_set_int(settings, "mix_preset", mix_preset_combo_->currentIndex());
+	obs_data_set_bool(settings, "warmup_sources", warmup_checkbox_->isChecked());
 
 	obs_data_save_json_safe(settings, path, "tmp", "bak");
 	obs_data_release(settings);
@@ -586,6 +935,9 @@ void LoudnessDock::load_settings()
 		cb->blockSignals(false);
 	}
 
+	// Restore output track checkboxes
+	sync_track_rows();
+
 	// Load other settings
 	int vad_thresh = static_cast<int>(obs_data_get_int(settings, "vad_threshold"));
 	if (vad_thresh != 0) {
@@ -603,6 +955,8 @@ void LoudnessDock::load_settings()
 	mix_preset_combo_->setCurrentIndex(mix_preset);
 	on_mix_preset_changed(mix_preset);
 
+	warmup_checkbox_->setChecked(obs_data_get_bool(settings, "warmup_sources"));
+
 	obs_data_release(settings);
 }
 
@@ -37,18 +37,37 @@ private slots:
 	void on_balance_target_changed(double value);
 	void on_mix_preset_changed(int index);
 	void on_refresh_sources();
+	void on_record_toggled(bool checked);
+	void on_warmup_toggled(bool checked);
+	void on_output_track_toggled(bool checked);
 
 private:
 	void setup_ui();
 	void refresh_source_lists();
 	void update_meters();
 	void update_status_colors();
+	void update_bgm_breakdown();
+	void update_track_meters();
+	void update_telemetry();
+	void log_telemetry();
+
+	// Pipeline telemetry of the measured output tracks, named for display
+	std::vector<AudioCaptureManager::SourceTelemetry> track_telemetry() const;
+
+	// Check the track boxes and show the meter rows of the tracks actually measured
+	void sync_track_rows();
 	void save_settings();
 	void load_settings();
 
 	// Convert LUFS to meter value (0-100)
 	int lufs_to_meter(double lufs) const;
 
+	// Show a true peak ("-- dBTP" when there is none)
+	void set_true_peak_label(QLabel *label, double dbtp) const;
+
+	// Integrated loudness and LRA since the monitor started, for the LUFS label tooltips
+	QString programme_text(double integrated_lufs, double lra) const;
+
 	// Get status color stylesheet
 	QString status_to_style(Status status) const;
 
@@ -69,8 +88,24 @@ private:
 	QLabel *voice_peak_label_{nullptr};
 	QLabel *bgm_peak_label_{nullptr};
 	QLabel *mix_peak_label_{nullptr};
+	QLabel *voice_true_peak_label_{nullptr};
+	QLabel *bgm_true_peak_label_{nullptr};
+	QLabel *mix_true_peak_label_{nullptr};
 	QLabel *delta_label_{nullptr};
 	QLabel *vad_indicator_{nullptr};
+	QLabel *pipeline_label_{nullptr};
+
+	// UI Components - Output tracks (a meter row per OBS mixer track, shown while the track is measured)
+	struct TrackRow {
+		QCheckBox *checkbox{nullptr};
+		QWidget *row{nullptr};
+		QProgressBar *meter{nullptr};
+		QLabel *lufs_label{nullptr};
+		QLabel *peak_label{nullptr};
+		QLabel *true_peak_label{nullptr};
+		QFrame *clip_status{nullptr};
+	};
+	TrackRow track_rows_[kMaxOutputTracks];
 
 	// UI Components - Status
 	QFrame *balance_status_{nullptr};
@@ -85,11 +120,18 @@ private:
 	QLabel *vad_threshold_value_{nullptr};
 	QDoubleSpinBox *balance_target_spin_{nullptr};
 	QComboBox *mix_preset_combo_{nullptr};
+	QCheckBox *warmup_checkbox_{nullptr};
+	QCheckBox *record_checkbox_{nullptr};
 
 	// Core components
 	std::unique_ptr<LoudnessAnalyzer> analyzer_;
 	std::unique_ptr<AudioCaptureManager> capture_manager_;
 	QTimer *update_timer_{nullptr};
+
+	// Periodic pipeline telemetry log (every kTelemetryLogTicks timer ticks)
+	static constexpr int kTelemetryLogTicks = 600; // 60 s at 10 Hz
+	int telemetry_ticks_{0};
+	uint64_t logged_drops_{0};
 };
 
 } // namespace lbm
@@ -0,0 +1,334 @@
+#include "audio-file.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lbm::tools {
+
+namespace {
+
+uint16_t read_u16(const uint8_t *p)
+{
+	return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t read_u32(const uint8_t *p)
+{
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+	       (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+constexpr uint16_t kWaveFormatPcm = 0x0001;
+constexpr uint16_t kWaveFormatFloat = 0x0003;
+constexpr uint16_t kWaveFormatExtensible = 0xFFFE;
+
+} // namespace
+
+// === MappedFile ===
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string &path)
+{
+	close();
+
+#ifdef _WIN32
+	file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			    FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file_ == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_, &file_size)) {
+		close();
+		return false;
+	}
+	size_ = static_cast<uint64_t>(file_size.QuadPart);
+
+	if (size_ > 0) {
+		mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping_) {
+			close();
+			return false;
+		}
+	}
+
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	granularity_ = info.dwAllocationGranularity;
+#else
+	fd_ = ::open(path.c_str(), O_RDONLY);
+	if (fd_ < 0) {
+		return false;
+	}
+
+	struct stat st {};
+	if (fstat(fd_, &st) != 0) {
+		close();
+		return false;
+	}
+	size_ = static_cast<uint64_t>(st.st_size);
+
+	long page = sysconf(_SC_PAGESIZE);
+	granularity_ = (page > 0) ? static_cast<uint64_t>(page) : 4096;
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	unmap();
+
+#ifdef _WIN32
+	if (mapping_) {
+		CloseHandle(mapping_);
+		mapping_ = nullptr;
+	}
+	if (file_ != INVALID_HANDLE_VALUE) {
+		CloseHandle(file_);
+		file_ = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (fd_ >= 0) {
+		::close(fd_);
+		fd_ = -1;
+	}
+#endif
+
+	size_ = 0;
+}
+
+void MappedFile::unmap()
+{
+	if (!window_) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(window_);
+#else
+	munmap(window_, window_size_);
+#endif
+
+	window_ = nullptr;
+	window_offset_ = 0;
+	window_size_ = 0;
+}
+
+const uint8_t *MappedFile::view(uint64_t offset, size_t length)
+{
+	if (length == 0 || offset + length > size_) {
+		return nullptr;
+	}
+
+	// Fast path: range already inside the current window
+	if (window_ && offset >= window_offset_ && offset + length <= window_offset_ + window_size_) {
+		return window_ + (offset - window_offset_);
+	}
+
+	unmap();
+
+	// Window starts at the aligned offset and always covers the requested range
+	uint64_t aligned = offset - (offset % granularity_);
+	size_t span = std::max(kWindowBytes, static_cast<size_t>(offset - aligned) + length);
+	size_t map_size = static_cast<size_t>(std::min<uint64_t>(span, size_ - aligned));
+
+#ifdef _WIN32
+	void *ptr = MapViewOfFile(mapping_, FILE_MAP_READ, static_cast<DWORD>(aligned >> 32),
+				  static_cast<DWORD>(aligned & 0xFFFFFFFFu), map_size);
+	if (!ptr) {
+		return nullptr;
+	}
+#else
+	void *ptr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd_, static_cast<off_t>(aligned));
+	if (ptr == MAP_FAILED) {
+		return nullptr;
+	}
+	madvise(ptr, map_size, MADV_SEQUENTIAL);
+#endif
+
+	window_ = static_cast<uint8_t *>(ptr);
+	window_offset_ = aligned;
+	window_size_ = map_size;
+	return window_ + (offset - window_offset_);
+}
+
+// === AudioFileReader ===
+
+bool AudioFileReader::open(const std::string &path, const RawFormat &raw_format)
+{
+	error_.clear();
+	position_ = 0;
+
+	if (!file_.open(path)) {
+		error_ = "cannot open " + path;
+		return false;
+	}
+
+	const uint8_t *header = file_.view(0, std::min<uint64_t>(12, file_.size()));
+	if (file_.size() >= 12 && std::memcmp(header, "RIFF", 4) == 0 && std::memcmp(header + 8, "WAVE", 4) == 0) {
+		if (!parse_wav()) {
+			error_ = path + ": " + error_;
+			return false;
+		}
+	} else {
+		// Raw interleaved float32 (little-endian)
+		if (raw_format.sample_rate == 0 || raw_format.channels == 0) {
+			error_ = path + ": invalid raw format";
+			return false;
+		}
+		format_ = SampleFormat::Float32;
+		bytes_per_sample_ = 4;
+		sample_rate_ = raw_format.sample_rate;
+		channels_ = raw_format.channels;
+		data_offset_ = 0;
+		total_frames_ = file_.size() / (bytes_per_sample_ * channels_);
+	}
+
+	return true;
+}
+
+bool AudioFileReader::parse_wav()
+{
+	uint64_t offset = 12;
+	bool have_fmt = false;
+
+	while (offset + 8 <= file_.size()) {
+		const uint8_t *chunk = file_.view(offset, 8);
+		uint32_t chunk_size = read_u32(chunk + 4);
+
+		if (std::memcmp(chunk, "fmt ", 4) == 0) {
+			if (chunk_size < 16) {
+				error_ = "malformed fmt chunk";
+				return false;
+			}
+			const uint8_t *fmt = file_.view(offset + 8, std::min<uint32_t>(chunk_size, 40));
+			if (!fmt) {
+				error_ = "truncated fmt chunk";
+				return false;
+			}
+
+			uint16_t tag = read_u16(fmt);
+			channels_ = read_u16(fmt + 2);
+			sample_rate_ = read_u32(fmt + 4);
+			uint16_t bits = read_u16(fmt + 14);
+
+			// WAVE_FORMAT_EXTENSIBLE: the real format tag is the first 2 bytes of the sub-format GUID
+			if (tag == kWaveFormatExtensible && chunk_size >= 26) {
+				tag = read_u16(fmt + 24);
+			}
+
+			if (tag == kWaveFormatFloat && bits == 32) {
+				format_ = SampleFormat::Float32;
+			} else if (tag == kWaveFormatPcm && bits == 16) {
+				format_ = SampleFormat::Int16;
+			} else if (tag == kWaveFormatPcm && bits == 24) {
+				format_ = SampleFormat::Int24;
+			} else if (tag == kWaveFormatPcm && bits == 32) {
+				format_ = SampleFormat::Int32;
+			} else {
+				error_ = "unsupported sample format";
+				return false;
+			}
+			bytes_per_sample_ = bits / 8;
+			have_fmt = true;
+		} else if (std::memcmp(chunk, "data", 4) == 0) {
+			if (!have_fmt || channels_ == 0 || sample_rate_ == 0) {
+				error_ = "data chunk before valid fmt chunk";
+				return false;
+			}
+			data_offset_ = offset + 8;
+			// Tolerate truncated files and 0xFFFFFFFF sizes written by streaming recorders
+			uint64_t data_size = std::min<uint64_t>(chunk_size, file_.size() - data_offset_);
+			total_frames_ = data_size / (static_cast<uint64_t>(bytes_per_sample_) * channels_);
+			return true;
+		}
+
+		// Chunks are padded to an even size
+		offset += 8 + chunk_size + (chunk_size & 1);
+	}
+
+	error_ = "no data chunk";
+	return false;
+}
+
+float AudioFileReader::sample_at(const uint8_t *p) const
+{
+	switch (format_) {
+	case SampleFormat::Int16:
+		return static_cast<int16_t>(read_u16(p)) / 32768.0f;
+	case SampleFormat::Int24: {
+		int32_t v = static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 |
+						 static_cast<uint32_t>(p[2]) << 24);
+		return (v >> 8) / 8388608.0f;
+	}
+	case SampleFormat::Int32:
+		return static_cast<int32_t>(read_u32(p)) / 2147483648.0f;
+	case SampleFormat::Float32: {
+		float f;
+		std::memcpy(&f, p, sizeof(f));
+		return f;
+	}
+	}
+	return 0.0f;
+}
+
+uint32_t AudioFileReader::read_planes(float *out, uint32_t channels, uint32_t frames)
+{
+	if (eof() || frames == 0 || channels == 0) {
+		return 0;
+	}
+
+	uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(frames, total_frames_ - position_));
+	const size_t frame_bytes = static_cast<size_t>(bytes_per_sample_) * channels_;
+	const uint8_t *src = file_.view(data_offset_ + position_ * frame_bytes, count * frame_bytes);
+	if (!src) {
+		error_ = "read failed";
+		position_ = total_frames_;
+		return 0;
+	}
+
+	if (channels == 1 && channels_ >= 2) {
+		// Stereo -> mono (average of the first two channels)
+		for (uint32_t i = 0; i < count; ++i) {
+			const uint8_t *frame = src + i * frame_bytes;
+			out[i] = (sample_at(frame) + sample_at(frame + bytes_per_sample_)) * 0.5f;
+		}
+	} else if (channels_ == 1) {
+		// Mono -> the front pair
+		const uint32_t copies = std::min<uint32_t>(channels, 2);
+		for (uint32_t i = 0; i < count; ++i) {
+			const float sample = sample_at(src + i * frame_bytes);
+			for (uint32_t c = 0; c < copies; ++c) {
+				out[c * count + i] = sample;
+			}
+		}
+		std::fill(out + copies * count, out + channels * count, 0.0f);
+	} else {
+		const uint32_t copies = std::min(channels, channels_);
+		for (uint32_t i = 0; i < count; ++i) {
+			const uint8_t *frame = src + i * frame_bytes;
+			for (uint32_t c = 0; c < copies; ++c) {
+				out[c * count + i] = sample_at(frame + c * bytes_per_sample_);
+			}
+		}
+		std::fill(out + copies * count, out + channels * count, 0.0f);
+	}
+
+	position_ += count;
+	return count;
+}
+
+} // namespace lbm::tools
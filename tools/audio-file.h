@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace lbm::tools {
+
+// Read-only memory-mapped file accessed through a sliding window
+// Only the window is mapped at any time, so memory use is constant regardless of file size
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	// Non-copyable
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool open(const std::string &path);
+	void close();
+
+	uint64_t size() const { return size_; }
+
+	// Get a pointer to [offset, offset + length) of the file, remapping the window if needed
+	// Returns nullptr if the range is outside the file or mapping fails
+	const uint8_t *view(uint64_t offset, size_t length);
+
+private:
+	void unmap();
+
+	// Mapped window size (re-mapped as reading advances)
+	static constexpr size_t kWindowBytes = 16 * 1024 * 1024;
+
+#ifdef _WIN32
+	HANDLE file_{INVALID_HANDLE_VALUE};
+	HANDLE mapping_{nullptr};
+#else
+	int fd_{-1};
+#endif
+	uint64_t size_{0};
+	uint64_t granularity_{4096};
+
+	uint8_t *window_{nullptr};
+	uint64_t window_offset_{0};
+	size_t window_size_{0};
+};
+
+// Streaming reader for WAV (PCM 16/24/32-bit, IEEE float 32-bit) or raw interleaved float32 files
+// Samples are delivered as planes in the channel count the analyzer measures (see read_planes)
+class AudioFileReader {
+public:
+	// Format used when the file has no RIFF/WAVE header
+	struct RawFormat {
+		uint32_t sample_rate{48000};
+		uint32_t channels{1};
+	};
+
+	bool open(const std::string &path, const RawFormat &raw_format);
+
+	uint32_t sample_rate() const { return sample_rate_; }
+	uint32_t channels() const { return channels_; }
+	uint64_t total_frames() const { return total_frames_; }
+	uint64_t position() const { return position_; }
+	bool eof() const { return position_ >= total_frames_; }
+
+	// Read up to `frames` frames as `channels` planes, plane c at out + c * count (out holds channels * frames)
+	//   1 channel:      mono files as is, others as the average of the first two channels
+	//   from mono file: the same samples on the first two channels (centred in front)
+	//   otherwise:      the file's channels in order; channels the file lacks are silent
+	// Returns the number of frames read, count (0 at end of file)
+	uint32_t read_planes(float *out, uint32_t channels, uint32_t frames);
+
+	const std::string &error() const { return error_; }
+
+private:
+	enum class SampleFormat { Int16, Int24, Int32, Float32 };
+
+	bool parse_wav();
+	float sample_at(const uint8_t *p) const;
+
+	MappedFile file_;
+	SampleFormat format_{SampleFormat::Float32};
+	uint32_t sample_rate_{0};
+	uint32_t channels_{0};
+	uint32_t bytes_per_sample_{4};
+	uint64_t data_offset_{0};
+	uint64_t total_frames_{0};
+	uint64_t position_{0};
+	std::string error_;
+};
+
+} // namespace lbm::tools
@@ -0,0 +1,230 @@
+// Offline file analysis with the same LoudnessAnalyzer logic the dock uses
+//
+// Streams a voice file and any number of BGM files block by block (memory-mapped, constant memory),
+// processes every block synchronously (no worker thread, no 1 ms polling) and writes a CSV timeline of
+// voice/BGM/mix LUFS, peaks, balance delta and judgments. --layout measures the files in an OBS speaker
+// layout (default mono, the files downmixed) the way the dock does for that output layout.
+
+#include "audio-file.h"
+#include "tool-common.h"
+
+#include "loudness-analyzer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace lbm;
+using namespace lbm::tools;
+
+namespace {
+
+struct Options {
+	std::string voice_path;
+	std::vector<std::string> bgm_paths;
+	std::string output_path;
+	uint32_t block{1024}; // OBS delivers 1024-frame audio ticks
+	double interval{0.1}; // timeline resolution in seconds (dock refreshes at 10 Hz)
+	AudioFileReader::RawFormat raw_format;
+	double balance_target{6.0};
+	int mix_preset{0};
+	LoudnessAnalyzer::MixMode mix_mode{LoudnessAnalyzer::MixMode::Derived};
+	LoudnessAnalyzer::LoudnessWindow window{LoudnessAnalyzer::LoudnessWindow::Shortterm};
+	ChannelLayout layout{ChannelLayout::Mono};
+};
+
+void print_usage(const char *argv0)
+{
+	std::fprintf(stderr,
+		     "Usage: %s --voice FILE [--bgm FILE]... [options]\n"
+		     "  --voice FILE          voice track (WAV or raw float32)\n"
+		     "  --bgm FILE            BGM track, may be repeated\n"
+		     "  --output FILE         CSV output (default stdout)\n"
+		     "  --block N             samples per block (default 1024, max %zu)\n"
+		     "  --interval SEC        timeline row interval (default 0.1)\n"
+		     "  --raw-rate N          sample rate for raw float32 input (default 48000)\n"
+		     "  --raw-channels N      channel count for raw float32 input (default 1)\n"
+		     "  --balance-target LU   balance target (default 6)\n"
+		     "  --mix-preset NAME     youtube | quiet | loud (default youtube)\n"
+		     "  --mix-mode MODE       derived | filtered: mix K-weighting (default derived)\n"
+		     "  --window NAME         momentary | shortterm: window of *_lufs and the judgments\n"
+		     "                        (default shortterm)\n"
+		     "  --layout NAME         mono | stereo | 2.1 | 4.0 | 4.1 | 5.1 | 7.1: measured channels\n"
+		     "                        (default mono: first two channels averaged)\n",
+		     argv0, AudioFrame::kMaxSamples);
+}
+
+bool parse_options(int argc, char **argv, Options &opts)
+{
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (!value) {
+			return false;
+		} else if (std::strcmp(arg, "--voice") == 0) {
+			opts.voice_path = value;
+		} else if (std::strcmp(arg, "--bgm") == 0) {
+			opts.bgm_paths.push_back(value);
+		} else if (std::strcmp(arg, "--output") == 0) {
+			opts.output_path = value;
+		} else if (std::strcmp(arg, "--block") == 0) {
+			opts.block = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		} else if (std::strcmp(arg, "--interval") == 0) {
+			opts.interval = std::atof(value);
+		} else if (std::strcmp(arg, "--raw-rate") == 0) {
+			opts.raw_format.sample_rate = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		} else if (std::strcmp(arg, "--raw-channels") == 0) {
+			opts.raw_format.channels = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		} else if (std::strcmp(arg, "--balance-target") == 0) {
+			opts.balance_target = std::atof(value);
+		} else if (std::strcmp(arg, "--mix-preset") == 0) {
+			if (!parse_mix_preset(value, opts.mix_preset)) {
+				return false;
+			}
+		} else if (std::strcmp(arg, "--mix-mode") == 0) {
+			if (!parse_mix_mode(value, opts.mix_mode)) {
+				return false;
+			}
+		} else if (std::strcmp(arg, "--window") == 0) {
+			if (!parse_window(value, opts.window)) {
+				return false;
+			}
+		} else if (std::strcmp(arg, "--layout") == 0) {
+			if (!parse_layout(value, opts.layout)) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+		++i;
+	}
+
+	return !opts.voice_path.empty() && opts.block > 0 && opts.block <= AudioFrame::kMaxSamples &&
+	       opts.interval > 0.0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	Options opts;
+	if (!parse_options(argc, argv, opts)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	AudioFileReader voice;
+	if (!voice.open(opts.voice_path, opts.raw_format)) {
+		std::fprintf(stderr, "error: %s\n", voice.error().c_str());
+		return 1;
+	}
+
+	if (opts.bgm_paths.size() > static_cast<size_t>(LoudnessAnalyzer::kMaxBgmInputs)) {
+		std::fprintf(stderr, "error: at most %d BGM files are supported\n", LoudnessAnalyzer::kMaxBgmInputs);
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<AudioFileReader>> bgms;
+	for (const auto &path : opts.bgm_paths) {
+		auto reader = std::make_unique<AudioFileReader>();
+		if (!reader->open(path, opts.raw_format)) {
+			std::fprintf(stderr, "error: %s\n", reader->error().c_str());
+			return 1;
+		}
+		if (reader->sample_rate() != voice.sample_rate()) {
+			std::fprintf(stderr, "error: %s: sample rate %u differs from voice (%u)\n", path.c_str(),
+				     reader->sample_rate(), voice.sample_rate());
+			return 1;
+		}
+		bgms.push_back(std::move(reader));
+	}
+
+	FILE *out = stdout;
+	if (!opts.output_path.empty()) {
+		out = std::fopen(opts.output_path.c_str(), "w");
+		if (!out) {
+			std::fprintf(stderr, "error: cannot write %s\n", opts.output_path.c_str());
+			return 1;
+		}
+	}
+
+	const uint32_t sample_rate = voice.sample_rate();
+
+	auto analyzer = std::make_unique<LoudnessAnalyzer>();
+	analyzer->set_sample_rate(sample_rate);
+	analyzer->set_channel_layout(opts.layout);
+	apply_analysis_config(opts.balance_target, opts.mix_preset, analyzer->config());
+
+	// One analyzer input per BGM file, as for BGM sources in OBS
+	std::vector<int> bgm_inputs;
+	for (size_t i = 0; i < bgms.size(); ++i) {
+		bgm_inputs.push_back(analyzer->add_bgm_input());
+	}
+	analyzer->set_mix_mode(opts.mix_mode);
+	analyzer->set_loudness_window(opts.window);
+	analyzer->start_offline();
+
+	print_timeline_header(out);
+
+	// Planar: read_planes() packs the planes as many samples apart as it read
+	const uint32_t channels = analyzer->channels();
+	std::vector<float> block(static_cast<size_t>(opts.block) * channels);
+	uint64_t frames_done = 0;
+	const uint64_t interval_frames = std::max<uint64_t>(1, static_cast<uint64_t>(opts.interval * sample_rate));
+	uint64_t next_row = interval_frames;
+
+	const auto wall_start = std::chrono::steady_clock::now();
+
+	for (;;) {
+		bool any = false;
+		uint32_t advanced = 0;
+
+		uint32_t n = voice.read_planes(block.data(), channels, opts.block);
+		if (n > 0) {
+			analyzer->push_voice_frame(block.data(), n);
+			advanced = n;
+			any = true;
+		}
+
+		for (size_t i = 0; i < bgms.size(); ++i) {
+			uint32_t m = bgms[i]->read_planes(block.data(), channels, opts.block);
+			if (m > 0) {
+				analyzer->push_bgm_frame(bgm_inputs[i], block.data(), m);
+				advanced = std::max(advanced, m);
+				any = true;
+			}
+		}
+
+		if (!any) {
+			break;
+		}
+
+		analyzer->process_pending();
+		frames_done += advanced;
+
+		while (frames_done >= next_row) {
+			print_timeline_row(out, static_cast<double>(next_row) / sample_rate, analyzer->results());
+			next_row += interval_frames;
+		}
+	}
+
+	if (!voice.error().empty()) {
+		std::fprintf(stderr, "warning: voice: %s\n", voice.error().c_str());
+	}
+
+	const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+	const double audio_seconds = static_cast<double>(frames_done) / sample_rate;
+	std::fprintf(stderr, "Analyzed %.1f s of audio in %.2f s (%.0fx realtime)\n", audio_seconds, wall,
+		     wall > 0.0 ? audio_seconds / wall : 0.0);
+
+	if (out != stdout) {
+		std::fclose(out);
+	}
+	return 0;
+}
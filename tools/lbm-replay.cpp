@@ -0,0 +1,256 @@
+// Replay a capture-callback recording (.lbmrec) through LoudnessAnalyzer
+//
+// Each recorded callback goes through the same filtering and fader as
+// AudioCaptureManager::voice_audio_callback / bgm_audio_callback, then is processed synchronously,
+// so the output is bit-identical across runs. --realtime paces records by their OBS timestamps.
+// The analyzer measures the recording's own layout unless --layout says otherwise; --layout mono averages
+// the first two channels, as the dock did before measuring every channel.
+
+#include "tool-common.h"
+
+#include "audio-kernels.h"
+#include "callback-recording.h"
+#include "loudness-analyzer.h"
+#include "timeline-clock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lbm;
+using namespace lbm::tools;
+
+namespace {
+
+struct Options {
+	std::string input_path;
+	std::string output_path;
+	bool realtime{false};
+	int digits{6};
+	double balance_target{6.0};
+	int mix_preset{0};
+	LoudnessAnalyzer::MixMode mix_mode{LoudnessAnalyzer::MixMode::Derived};
+	LoudnessAnalyzer::LoudnessWindow window{LoudnessAnalyzer::LoudnessWindow::Shortterm};
+	bool auto_layout{true}; // Layout of the first record
+	ChannelLayout layout{ChannelLayout::Mono};
+};
+
+void print_usage(const char *argv0)
+{
+	std::fprintf(stderr,
+		     "Usage: %s --input FILE [options]\n"
+		     "  --input FILE          capture recording (.lbmrec)\n"
+		     "  --output FILE         CSV output, one row per callback (default stdout)\n"
+		     "  --realtime            replay with the original callback timing (default: maximum speed)\n"
+		     "  --digits N            decimal places for dB values (default 6)\n"
+		     "  --balance-target LU   balance target (default 6)\n"
+		     "  --mix-preset NAME     youtube | quiet | loud (default youtube)\n"
+		     "  --mix-mode MODE       derived | filtered: mix K-weighting (default derived)\n"
+		     "  --window NAME         momentary | shortterm: window of *_lufs and the judgments\n"
+		     "                        (default shortterm)\n"
+		     "  --layout NAME         auto | mono | stereo | 2.1 | 4.0 | 4.1 | 5.1 | 7.1: measured channels\n"
+		     "                        (default auto: the recording's own)\n",
+		     argv0);
+}
+
+bool parse_options(int argc, char **argv, Options &opts)
+{
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (std::strcmp(arg, "--realtime") == 0) {
+			opts.realtime = true;
+			continue;
+		}
+
+		if (!value) {
+			return false;
+		} else if (std::strcmp(arg, "--input") == 0) {
+			opts.input_path = value;
+		} else if (std::strcmp(arg, "--output") == 0) {
+			opts.output_path = value;
+		} else if (std::strcmp(arg, "--digits") == 0) {
+			opts.digits = std::atoi(value);
+		} else if (std::strcmp(arg, "--balance-target") == 0) {
+			opts.balance_target = std::atof(value);
+		} else if (std::strcmp(arg, "--mix-preset") == 0) {
+			if (!parse_mix_preset(value, opts.mix_preset)) {
+				return false;
+			}
+		} else if (std::strcmp(arg, "--mix-mode") == 0) {
+			if (!parse_mix_mode(value, opts.mix_mode)) {
+				return false;
+			}
+		} else if (std::strcmp(arg, "--window") == 0) {
+			if (!parse_window(value, opts.window)) {
+				return false;
+			}
+		} else if (std::strcmp(arg, "--layout") == 0) {
+			opts.auto_layout = std::strcmp(value, "auto") == 0;
+			if (!opts.auto_layout && !parse_layout(value, opts.layout)) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+		++i;
+	}
+
+	return !opts.input_path.empty() && opts.digits >= 0 && opts.digits <= 17;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	Options opts;
+	if (!parse_options(argc, argv, opts)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	CallbackRecordingReader reader;
+	if (!reader.open(opts.input_path)) {
+		std::fprintf(stderr, "error: %s\n", reader.error().c_str());
+		return 1;
+	}
+
+	FILE *out = stdout;
+	if (!opts.output_path.empty()) {
+		out = std::fopen(opts.output_path.c_str(), "w");
+		if (!out) {
+			std::fprintf(stderr, "error: cannot write %s\n", opts.output_path.c_str());
+			return 1;
+		}
+	}
+
+	auto analyzer = std::make_unique<LoudnessAnalyzer>();
+	analyzer->set_sample_rate(reader.sample_rate());
+	apply_analysis_config(opts.balance_target, opts.mix_preset, analyzer->config());
+	analyzer->set_mix_mode(opts.mix_mode);
+	analyzer->set_loudness_window(opts.window);
+	bool started = false; // Once the layout is known
+
+	// Mono layout: the first two channels averaged before the fader
+	std::vector<float> downmix(AudioFrame::kMaxSamples);
+
+	// Analyzer BGM input per recorded source id, assigned on first appearance
+	std::map<uint32_t, int> bgm_inputs;
+
+	print_timeline_header(out);
+
+	RecordedCallback record;
+	uint64_t records = 0;
+	uint64_t first_timestamp = 0;
+	const auto wall_start = std::chrono::steady_clock::now();
+
+	while (reader.next(record)) {
+		if (records++ == 0) {
+			first_timestamp = record.timestamp;
+		}
+		const uint64_t offset_ns = record.timestamp >= first_timestamp ? record.timestamp - first_timestamp : 0;
+
+		if (opts.realtime) {
+			std::this_thread::sleep_until(wall_start + std::chrono::nanoseconds(offset_ns));
+		}
+
+		if (record.channels == 0 || record.frames == 0) {
+			continue;
+		}
+
+		if (!started) {
+			ChannelLayout layout = opts.layout;
+			if (opts.auto_layout && !layout_for_channels(record.channels, layout)) {
+				layout = ChannelLayout::Stereo; // No OBS layout has this many; measure the front pair
+			}
+			analyzer->set_channel_layout(layout);
+			analyzer->start_offline();
+			started = true;
+		}
+
+		const bool voice = record.stream == RecordedStream::Voice;
+		int input = -1;
+		if (!voice) {
+			auto it = bgm_inputs.find(record.source_id);
+			if (it == bgm_inputs.end()) {
+				it = bgm_inputs.emplace(record.source_id, analyzer->add_bgm_input()).first;
+			}
+			input = it->second;
+		}
+
+		// Same filtering and drop accounting as the capture callbacks
+		if (record.muted || record.frames > AudioFrame::kMaxSamples) {
+			const DropReason reason = record.muted ? DropReason::Muted : DropReason::Oversized;
+			if (voice) {
+				analyzer->count_voice_drop(reason, record.frames);
+			} else {
+				analyzer->count_bgm_drop(input, reason, record.frames);
+			}
+			continue;
+		}
+
+		// Copy straight into the queue, as the capture callbacks do
+		const uint64_t timestamp = TimelineClock::apply_sync_offset(record.timestamp, record.sync_offset);
+		float *samples = voice ? analyzer->reserve_voice_frame(record.frames)
+				       : analyzer->reserve_bgm_frame(input, record.frames);
+		if (samples) {
+			const float *planes[kMaxChannels]{};
+			const uint32_t channels = analyzer->channels();
+			if (channels == 1 && record.channels >= 2) {
+				for (uint32_t i = 0; i < record.frames; ++i) {
+					downmix[i] = (record.planes[0][i] + record.planes[1][i]) * 0.5f;
+				}
+				planes[0] = downmix.data();
+			} else {
+				std::copy(record.planes, record.planes + std::min(channels, record.channels), planes);
+			}
+			if (voice) {
+				HopEnergy hops = analyzer->next_voice_hops();
+				const BlockStats stats = kernels::capture_planes(
+					planes, channels, samples, record.frames, record.volume, hops);
+				analyzer->commit_voice_frame(record.frames, stats, timestamp, &hops);
+			} else {
+				const BlockStats stats = kernels::capture_planes(planes, channels, samples,
+										 record.frames, record.volume);
+				analyzer->commit_bgm_frame(input, record.frames, stats, timestamp);
+			}
+		}
+		analyzer->process_pending();
+
+		print_timeline_row(out, offset_ns * 1e-9, analyzer->results(), opts.digits);
+	}
+
+	if (!reader.error().empty()) {
+		std::fprintf(stderr, "warning: %s (stopped after %llu records)\n", reader.error().c_str(),
+			     static_cast<unsigned long long>(records));
+	}
+
+	const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+	std::fprintf(stderr, "Replayed %llu callbacks in %.2f s\n", static_cast<unsigned long long>(records), wall);
+
+	// Pipeline telemetry, as logged by the dock
+	auto print_stream = [](const char *name, uint32_t id, const StreamTelemetry &t) {
+		std::fprintf(stderr, "  %s %u: pushed=%llu dropped_full=%llu oversized=%llu muted=%llu\n", name, id,
+			     static_cast<unsigned long long>(t.pushed_blocks),
+			     static_cast<unsigned long long>(t.dropped_full_blocks),
+			     static_cast<unsigned long long>(t.oversized_blocks),
+			     static_cast<unsigned long long>(t.muted_blocks));
+	};
+	print_stream("voice", 0, analyzer->voice_telemetry());
+	for (const auto &entry : bgm_inputs) {
+		print_stream("bgm", entry.first, analyzer->bgm_telemetry(entry.second));
+	}
+
+	if (out != stdout) {
+		std::fclose(out);
+	}
+	return 0;
+}
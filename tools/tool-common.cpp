@@ -0,0 +1,129 @@
+#include "tool-common.h"
+
+#include <cstring>
+
+namespace lbm::tools {
+
+namespace {
+
+void print_db(FILE *out, double value, int digits)
+{
+	if (value == -HUGE_VAL) {
+		std::fputs(",", out);
+	} else {
+		std::fprintf(out, ",%.*f", digits, value);
+	}
+}
+
+} // namespace
+
+bool parse_mix_preset(const char *name, int &preset)
+{
+	if (std::strcmp(name, "youtube") == 0) {
+		preset = 0;
+	} else if (std::strcmp(name, "quiet") == 0) {
+		preset = 1;
+	} else if (std::strcmp(name, "loud") == 0) {
+		preset = 2;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool parse_mix_mode(const char *name, LoudnessAnalyzer::MixMode &mode)
+{
+	if (std::strcmp(name, "derived") == 0) {
+		mode = LoudnessAnalyzer::MixMode::Derived;
+	} else if (std::strcmp(name, "filtered") == 0) {
+		mode = LoudnessAnalyzer::MixMode::Filtered;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool parse_window(const char *name, LoudnessAnalyzer::LoudnessWindow &window)
+{
+	if (std::strcmp(name, "momentary") == 0) {
+		window = LoudnessAnalyzer::LoudnessWindow::Momentary;
+	} else if (std::strcmp(name, "shortterm") == 0) {
+		window = LoudnessAnalyzer::LoudnessWindow::Shortterm;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool parse_layout(const char *name, ChannelLayout &layout)
+{
+	for (uint32_t channels = 1; channels <= kMaxChannels; ++channels) {
+		ChannelLayout candidate;
+		if (layout_for_channels(channels, candidate) &&
+		    std::strcmp(name, channel_layout_name(candidate)) == 0) {
+			layout = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+void apply_analysis_config(double balance_target, int mix_preset, AnalysisConfig &config)
+{
+	// {OK, WARN} thresholds per preset
+	static constexpr double kPresets[][2] = {{-18.0, -22.0}, {-20.0, -24.0}, {-16.0, -20.0}};
+	if (mix_preset < 0 || mix_preset > 2) {
+		mix_preset = 0;
+	}
+
+	config.balance_target.store(balance_target, std::memory_order_relaxed);
+	config.mix_ok_threshold.store(kPresets[mix_preset][0], std::memory_order_relaxed);
+	config.mix_warn_threshold.store(kPresets[mix_preset][1], std::memory_order_relaxed);
+}
+
+void print_timeline_header(FILE *out)
+{
+	std::fprintf(out, "time_s,voice_lufs,bgm_lufs,mix_lufs,voice_peak_dbfs,bgm_peak_dbfs,mix_peak_dbfs,"
+			  "voice_true_peak_dbtp,bgm_true_peak_dbtp,mix_true_peak_dbtp,"
+			  "voice_integrated_lufs,bgm_integrated_lufs,mix_integrated_lufs,voice_lra,bgm_lra,mix_lra,"
+			  "balance_delta,voice_active,balance_status,mix_status,clip_status\n");
+}
+
+void print_timeline_row(FILE *out, double time_s, const AnalysisResults &r, int digits)
+{
+	std::fprintf(out, "%.3f", time_s);
+	print_db(out, r.voice_lufs.load(std::memory_order_relaxed), digits);
+	print_db(out, r.bgm_lufs.load(std::memory_order_relaxed), digits);
+	print_db(out, r.mix_lufs.load(std::memory_order_relaxed), digits);
+	print_db(out, r.voice_peak_dbfs.load(std::memory_order_relaxed), digits);
+	print_db(out, r.bgm_peak_dbfs.load(std::memory_order_relaxed), digits);
+	print_db(out, r.mix_peak_dbfs.load(std::memory_order_relaxed), digits);
+	print_db(out, r.voice_true_peak_dbtp.load(std::memory_order_relaxed), digits);
+	print_db(out, r.bgm_true_peak_dbtp.load(std::memory_order_relaxed), digits);
+	print_db(out, r.mix_true_peak_dbtp.load(std::memory_order_relaxed), digits);
+	print_db(out, r.voice_integrated_lufs.load(std::memory_order_relaxed), digits);
+	print_db(out, r.bgm_integrated_lufs.load(std::memory_order_relaxed), digits);
+	print_db(out, r.mix_integrated_lufs.load(std::memory_order_relaxed), digits);
+	std::fprintf(out, ",%.*f,%.*f,%.*f", digits, r.voice_lra.load(std::memory_order_relaxed), digits,
+		     r.bgm_lra.load(std::memory_order_relaxed), digits, r.mix_lra.load(std::memory_order_relaxed));
+	std::fprintf(out, ",%.*f,%d,%s,%s,%s\n", digits, r.balance_delta.load(std::memory_order_relaxed),
+		     r.voice_active.load(std::memory_order_relaxed) ? 1 : 0,
+		     status_name(r.balance_status.load(std::memory_order_relaxed)),
+		     status_name(r.mix_status.load(std::memory_order_relaxed)),
+		     status_name(r.clip_status.load(std::memory_order_relaxed)));
+}
+
+const char *status_name(Status status)
+{
+	switch (status) {
+	case Status::OK:
+		return "OK";
+	case Status::WARN:
+		return "WARN";
+	case Status::BAD:
+		return "BAD";
+	}
+	return "";
+}
+
+} // namespace lbm::tools
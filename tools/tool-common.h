@@ -0,0 +1,37 @@
+#pragma once
+
+#include "analysis-results.h"
+#include "loudness-analyzer.h"
+
+#include <cstdio>
+
+namespace lbm::tools {
+
+// Helpers shared by the offline tools
+
+// Mix preset name ("youtube" | "quiet" | "loud") -> index used by the dock's preset combo
+bool parse_mix_preset(const char *name, int &preset);
+
+// Mix mode name ("derived" | "filtered") -> LoudnessAnalyzer::MixMode
+bool parse_mix_mode(const char *name, LoudnessAnalyzer::MixMode &mode);
+
+// Window name ("momentary" | "shortterm") -> LoudnessAnalyzer::LoudnessWindow
+bool parse_window(const char *name, LoudnessAnalyzer::LoudnessWindow &window);
+
+// Layout name ("mono" | "stereo" | "2.1" | "4.0" | "4.1" | "5.1" | "7.1") -> ChannelLayout
+bool parse_layout(const char *name, ChannelLayout &layout);
+
+// Apply balance target and mix preset thresholds (same values as LoudnessDock::on_mix_preset_changed)
+void apply_analysis_config(double balance_target, int mix_preset, AnalysisConfig &config);
+
+// CSV timeline of AnalysisResults
+// Empty fields mean "no measurement yet" (-inf)
+
+void print_timeline_header(FILE *out);
+
+// `digits` = decimal places for dB / LU values
+void print_timeline_row(FILE *out, double time_s, const AnalysisResults &results, int digits = 2);
+
+const char *status_name(Status status);
+
+} // namespace lbm::tools